@@ -36,6 +36,7 @@ public class OnlineSubsystemDrift : ModuleRules
                 "CoreUObject",
                 "Engine",
                 "Sockets",
+                "Json",
                 "Voice",
                 "OnlineSubsystem",
                 "Drift",
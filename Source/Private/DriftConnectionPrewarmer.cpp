@@ -0,0 +1,104 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftConnectionPrewarmer.h"
+#include "DriftLatencyProber.h"
+
+
+FDriftConnectionPrewarmer::FDriftConnectionPrewarmer()
+{
+    GConfig->GetBool(DRIFT_CONFIG_SECTION, TEXT("MatchPrewarm"), bEnabled, GEngineIni);
+    GConfig->GetBool(DRIFT_CONFIG_SECTION, TEXT("MatchPrewarmHandshake"), bHandshake, GEngineIni);
+    GConfig->GetInt(DRIFT_CONFIG_SECTION, TEXT("MatchPrewarmCacheSize"), CacheSize, GEngineIni);
+    CacheSize = FMath::Max(CacheSize, 1);
+}
+
+void FDriftConnectionPrewarmer::Prewarm(const FString& ConnectionUrl)
+{
+    if (!bEnabled || FindEntry(ConnectionUrl) != nullptr)
+    {
+        return;
+    }
+
+    FEntry NewEntry;
+    if (!DriftParseConnectionUrl(ConnectionUrl, NewEntry.Host, NewEntry.Port))
+    {
+        UE_LOG_ONLINE(Verbose, TEXT("Can't prewarm '%s', no host in url"), *ConnectionUrl);
+        return;
+    }
+    NewEntry.Url = ConnectionUrl;
+    NewEntry.StartTime = FPlatformTime::Seconds();
+
+    if (!NewEntry.Resolver.Start(NewEntry.Host, NewEntry.Port))
+    {
+        UE_LOG_ONLINE(Verbose, TEXT("Can't prewarm '%s', failed to start resolving"), *ConnectionUrl);
+        return;
+    }
+
+    Entries.Add(MoveTemp(NewEntry));
+    Trim();
+}
+
+bool FDriftConnectionPrewarmer::GetResolvedUrl(const FString& ConnectionUrl, FString& OutUrl) const
+{
+    const auto Entry = FindEntry(ConnectionUrl);
+    if (Entry == nullptr || !Entry->Resolver.GetAddress().IsValid())
+    {
+        return false;
+    }
+
+    OutUrl = Entry->Resolver.GetAddress()->ToString(true);
+    int32 OptionsStart = INDEX_NONE;
+    if (ConnectionUrl.FindChar(TEXT('?'), OptionsStart))
+    {
+        OutUrl += ConnectionUrl.Mid(OptionsStart);
+    }
+    return true;
+}
+
+TSharedPtr<const FInternetAddr> FDriftConnectionPrewarmer::FindAddress(const FString& ConnectionUrl) const
+{
+    const auto Entry = FindEntry(ConnectionUrl);
+    return Entry ? Entry->Resolver.GetAddress() : nullptr;
+}
+
+void FDriftConnectionPrewarmer::Tick(float DeltaTime)
+{
+    for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+    {
+        auto& Entry = Entries[Index];
+        if (!Entry.Resolver.IsResolving() || !Entry.Resolver.Poll())
+        {
+            continue;
+        }
+
+        const auto& Address = Entry.Resolver.GetAddress();
+        if (Address.IsValid())
+        {
+            UE_LOG_ONLINE(Verbose, TEXT("Prewarmed '%s' as %s in %.1f ms"),
+                *Entry.Host, *Address->ToString(true), (FPlatformTime::Seconds() - Entry.StartTime) * 1000.0);
+        }
+        else
+        {
+            UE_LOG_ONLINE(Log, TEXT("Failed to resolve '%s' ahead of travel"), *Entry.Host);
+            Entries.RemoveAt(Index);
+        }
+    }
+}
+
+const FDriftConnectionPrewarmer::FEntry* FDriftConnectionPrewarmer::FindEntry(const FString& ConnectionUrl) const
+{
+    return Entries.FindByPredicate([&ConnectionUrl](const FEntry& Entry)
+    {
+        return Entry.Url == ConnectionUrl;
+    });
+}
+
+void FDriftConnectionPrewarmer::Trim()
+{
+    if (Entries.Num() > CacheSize)
+    {
+        // Their resolvers abandon whatever is still in progress
+        Entries.RemoveAt(0, Entries.Num() - CacheSize);
+    }
+}
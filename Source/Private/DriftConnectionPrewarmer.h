@@ -0,0 +1,66 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "DriftHostResolver.h"
+
+
+/**
+ * Resolves the servers of freshly found matches ahead of travel
+ *
+ * Name resolution otherwise happens when the game travels to the match, after JoinSession has run its course.
+ * Prewarm() starts it the moment a match is found, and once the address is known GetResolvedUrl() hands out
+ * the connection url with the host replaced by it, so travel doesn't have to wait on DNS.
+ * Only the most recent few servers are kept, resolves that fall out of the cache are abandoned.
+ *
+ * Tunables are read from the [OnlineSubsystemDrift] section of the engine ini:
+ * MatchPrewarm (on by default), MatchPrewarmHandshake (also probe the server once resolved, off by default)
+ * and MatchPrewarmCacheSize.
+ */
+class FDriftConnectionPrewarmer
+{
+public:
+    FDriftConnectionPrewarmer();
+
+    bool IsEnabled() const { return bEnabled; }
+
+    /** Whether matched servers should also get a reachability handshake, see FDriftLatencyProber */
+    bool WantsHandshake() const { return bEnabled && bHandshake; }
+
+    /** Start resolving the server in a connection url, unless it already is */
+    void Prewarm(const FString& ConnectionUrl);
+
+    /**
+     * @param ConnectionUrl a url passed to Prewarm()
+     * @param OutUrl the url with its host replaced by the resolved address
+     * @return false if the url hasn't been resolved (yet)
+     */
+    bool GetResolvedUrl(const FString& ConnectionUrl, FString& OutUrl) const;
+
+    /** @return the resolved address of the server in a connection url, or nullptr if it hasn't been resolved (yet) */
+    TSharedPtr<const FInternetAddr> FindAddress(const FString& ConnectionUrl) const;
+
+    void Tick(float DeltaTime);
+
+private:
+    struct FEntry
+    {
+        FString Url;
+        FString Host;
+        int32 Port{ 0 };
+        FDriftHostResolver Resolver;
+        double StartTime{ 0.0 };
+    };
+
+    const FEntry* FindEntry(const FString& ConnectionUrl) const;
+
+    /** Drop the oldest entries beyond the cache size */
+    void Trim();
+
+    bool bEnabled{ true };
+    bool bHandshake{ false };
+    int32 CacheSize{ 4 };
+
+    /** Oldest first */
+    TArray<FEntry> Entries;
+};
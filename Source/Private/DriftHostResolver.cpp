@@ -0,0 +1,115 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftHostResolver.h"
+#include "SocketSubsystem.h"
+
+
+/** Resolves nobody is waiting for any more, deleted once their workers are done */
+static TArray<FResolveInfo*>& GetAbandonedResolves()
+{
+    static TArray<FResolveInfo*> AbandonedResolves;
+    return AbandonedResolves;
+}
+
+
+FDriftHostResolver::FDriftHostResolver(FDriftHostResolver&& Other)
+: ResolveInfo(Other.ResolveInfo)
+, Address(MoveTemp(Other.Address))
+, Port(Other.Port)
+{
+    Other.ResolveInfo = nullptr;
+}
+
+FDriftHostResolver& FDriftHostResolver::operator=(FDriftHostResolver&& Other)
+{
+    if (this != &Other)
+    {
+        Abandon();
+        ResolveInfo = Other.ResolveInfo;
+        Address = MoveTemp(Other.Address);
+        Port = Other.Port;
+        Other.ResolveInfo = nullptr;
+    }
+    return *this;
+}
+
+FDriftHostResolver::~FDriftHostResolver()
+{
+    Abandon();
+}
+
+bool FDriftHostResolver::Start(const FString& Host, int32 InPort)
+{
+    Abandon();
+    Address.Reset();
+    Port = InPort;
+
+    auto SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    bool bIsValidIp = false;
+    auto NumericAddress = SocketSubsystem->CreateInternetAddr();
+    NumericAddress->SetIp(*Host, bIsValidIp);
+    if (bIsValidIp)
+    {
+        NumericAddress->SetPort(Port);
+        Address = NumericAddress;
+        return true;
+    }
+
+    ReapAbandoned();
+    ResolveInfo = SocketSubsystem->GetHostByName(TCHAR_TO_ANSI(*Host));
+    return ResolveInfo != nullptr;
+}
+
+bool FDriftHostResolver::Poll()
+{
+    if (ResolveInfo == nullptr)
+    {
+        return true;
+    }
+    if (!ResolveInfo->IsComplete())
+    {
+        return false;
+    }
+
+    if (ResolveInfo->GetErrorCode() == 0)
+    {
+        uint32 Ip = 0;
+        ResolveInfo->GetResolvedAddress().GetIp(Ip);
+        Address = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr(Ip, Port);
+    }
+    delete ResolveInfo;
+    ResolveInfo = nullptr;
+    return true;
+}
+
+void FDriftHostResolver::Abandon()
+{
+    if (ResolveInfo == nullptr)
+    {
+        return;
+    }
+
+    if (ResolveInfo->IsComplete())
+    {
+        delete ResolveInfo;
+    }
+    else
+    {
+        GetAbandonedResolves().Add(ResolveInfo);
+    }
+    ResolveInfo = nullptr;
+}
+
+void FDriftHostResolver::ReapAbandoned()
+{
+    auto& AbandonedResolves = GetAbandonedResolves();
+    for (int32 Index = AbandonedResolves.Num() - 1; Index >= 0; --Index)
+    {
+        if (AbandonedResolves[Index]->IsComplete())
+        {
+            delete AbandonedResolves[Index];
+            AbandonedResolves.RemoveAtSwap(Index);
+        }
+    }
+}
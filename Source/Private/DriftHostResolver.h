@@ -0,0 +1,59 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "IPAddress.h"
+
+class FResolveInfo;
+
+
+/**
+ * Resolves a host name without ever waiting on DNS
+ *
+ * Wraps ISocketSubsystem::GetHostByName(), numeric addresses are taken as they are. A resolve that is still
+ * running when it's given up on, or when the resolver goes away, can't be deleted until its worker is done
+ * with it, so it is handed over to a list of abandoned resolves that later resolvers clean up.
+ * Whatever is still running at exit is leaked. Game thread only.
+ */
+class FDriftHostResolver
+{
+public:
+    FDriftHostResolver() {}
+    FDriftHostResolver(FDriftHostResolver&& Other);
+    FDriftHostResolver& operator=(FDriftHostResolver&& Other);
+    ~FDriftHostResolver();
+
+    /**
+     * Start resolving a host, giving up on any resolve in progress
+     *
+     * @param Port the port of the resolved address
+     * @return false if resolution couldn't be started
+     */
+    bool Start(const FString& Host, int32 Port);
+
+    /**
+     * Check on the resolve in progress
+     *
+     * @return true once there's nothing left to wait for, GetAddress() is valid if resolution succeeded
+     */
+    bool Poll();
+
+    bool IsResolving() const { return ResolveInfo != nullptr; }
+
+    /** The resolved address, invalid until resolution succeeded */
+    const TSharedPtr<FInternetAddr>& GetAddress() const { return Address; }
+
+    /** Stop waiting for the resolve in progress, if any */
+    void Abandon();
+
+private:
+    FDriftHostResolver(const FDriftHostResolver&) = delete;
+    FDriftHostResolver& operator=(const FDriftHostResolver&) = delete;
+
+    /** Delete the abandoned resolves whose workers have finished */
+    static void ReapAbandoned();
+
+    FResolveInfo* ResolveInfo{ nullptr };
+    TSharedPtr<FInternetAddr> Address;
+    int32 Port{ 0 };
+};
@@ -0,0 +1,282 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftLatencyProber.h"
+#include "OnlineSessionSettings.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+
+/** Marks a datagram as a Drift latency probe, followed by the probe nonce */
+static const uint32 LatencyProbeMagic = 0x54465244; // "DRFT"
+static const int32 LatencyProbeSize = 8;
+static const int32 DefaultGamePort = 7777;
+
+
+static void WriteUInt32(uint8* Dest, uint32 Value)
+{
+    Dest[0] = Value & 0xff;
+    Dest[1] = (Value >> 8) & 0xff;
+    Dest[2] = (Value >> 16) & 0xff;
+    Dest[3] = (Value >> 24) & 0xff;
+}
+
+static uint32 ReadUInt32(const uint8* Src)
+{
+    return Src[0] | (Src[1] << 8) | (Src[2] << 16) | (uint32(Src[3]) << 24);
+}
+
+
+bool DriftParseConnectionUrl(const FString& ConnectionUrl, FString& OutHost, int32& OutPort)
+{
+    FString Address = ConnectionUrl;
+    int32 OptionsStart = INDEX_NONE;
+    if (Address.FindChar(TEXT('?'), OptionsStart))
+    {
+        Address = Address.Left(OptionsStart);
+    }
+
+    int32 PortStart = INDEX_NONE;
+    OutPort = DefaultGamePort;
+    if (Address.FindLastChar(TEXT(':'), PortStart))
+    {
+        OutPort = FCString::Atoi(*Address.Mid(PortStart + 1));
+        Address = Address.Left(PortStart);
+    }
+    OutHost = Address;
+
+    return !OutHost.IsEmpty() && OutPort > 0 && OutPort <= MAX_uint16;
+}
+
+
+FDriftLatencyProber::FDriftLatencyProber()
+{
+    GConfig->GetInt(DRIFT_CONFIG_SECTION, TEXT("LatencyProbePort"), ProbePort, GEngineIni);
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("LatencyProbeTimeout"), Timeout, GEngineIni);
+    GConfig->GetInt(DRIFT_CONFIG_SECTION, TEXT("LatencyProbeMaxInFlight"), MaxInFlight, GEngineIni);
+    MaxInFlight = FMath::Max(MaxInFlight, 1);
+}
+
+FDriftLatencyProber::~FDriftLatencyProber()
+{
+    // Resolves still in progress are abandoned with their probes, nothing waits for them
+    if (Socket)
+    {
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+        Socket = nullptr;
+    }
+}
+
+void FDriftLatencyProber::Probe(const FString& ConnectionUrl, const FOnLatencyProbeComplete& Delegate)
+{
+    auto& NewProbe = Pending[Pending.AddDefaulted()];
+    NewProbe.Delegate = Delegate;
+    if (!IsEnabled() || !DriftParseConnectionUrl(ConnectionUrl, NewProbe.Host, NewProbe.Port))
+    {
+        // Fails in the next Tick()
+        NewProbe.Host.Empty();
+    }
+    else
+    {
+        NewProbe.Port = ProbePort;
+    }
+}
+
+void FDriftLatencyProber::Tick(float DeltaTime)
+{
+    if (IsIdle())
+    {
+        return;
+    }
+
+    // Delegates run last, they may well queue new probes
+    TArray<TPair<FOnLatencyProbeComplete, int32>> Completed;
+
+    if (Socket)
+    {
+        ReceiveReplies(Completed);
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    for (int32 Index = InFlight.Num() - 1; Index >= 0; --Index)
+    {
+        auto& Probe = InFlight[Index];
+        if (Probe.Resolver.IsResolving() && Probe.Resolver.Poll())
+        {
+            if (!Probe.Resolver.GetAddress().IsValid() || !SendEcho(Probe))
+            {
+                UE_LOG_ONLINE(Verbose, TEXT("Latency probe to '%s' failed"), *Probe.Host);
+                Completed.Emplace(Probe.Delegate, MAX_QUERY_PING);
+                InFlight.RemoveAtSwap(Index);
+                continue;
+            }
+        }
+
+        if (Now - Probe.StartTime > Timeout)
+        {
+            // A resolve that's still running is abandoned with the probe
+            Completed.Emplace(Probe.Delegate, MAX_QUERY_PING);
+            InFlight.RemoveAtSwap(Index);
+        }
+    }
+
+    int32 NumStarted = 0;
+    for (; NumStarted < Pending.Num() && InFlight.Num() < MaxInFlight; ++NumStarted)
+    {
+        FProbe& Probe = Pending[NumStarted];
+        if (StartProbe(Probe))
+        {
+            InFlight.Add(MoveTemp(Probe));
+        }
+        else
+        {
+            Completed.Emplace(Probe.Delegate, MAX_QUERY_PING);
+        }
+    }
+    Pending.RemoveAt(0, NumStarted, false);
+
+    for (auto& Result : Completed)
+    {
+        Result.Key.ExecuteIfBound(Result.Value);
+    }
+}
+
+bool FDriftLatencyProber::CreateSocket()
+{
+    auto SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    Socket = SocketSubsystem->CreateSocket(NAME_DGram, TEXT("DriftLatencyProbe"), false);
+    if (Socket && !Socket->SetNonBlocking(true))
+    {
+        SocketSubsystem->DestroySocket(Socket);
+        Socket = nullptr;
+    }
+    if (Socket == nullptr)
+    {
+        UE_LOG_ONLINE(Warning, TEXT("Failed to create a socket for latency probes"));
+    }
+    return Socket != nullptr;
+}
+
+bool FDriftLatencyProber::StartProbe(FProbe& Probe)
+{
+    if (Probe.Host.IsEmpty() || (Socket == nullptr && !CreateSocket()))
+    {
+        return false;
+    }
+
+    Probe.Nonce = NextNonce++;
+    Probe.StartTime = FPlatformTime::Seconds();
+
+    if (!Probe.Resolver.Start(Probe.Host, Probe.Port))
+    {
+        return false;
+    }
+    // Numeric addresses don't need resolving
+    return Probe.Resolver.IsResolving() || SendEcho(Probe);
+}
+
+bool FDriftLatencyProber::SendEcho(FProbe& Probe)
+{
+    uint8 Request[LatencyProbeSize];
+    WriteUInt32(Request, LatencyProbeMagic);
+    WriteUInt32(Request + 4, Probe.Nonce);
+
+    int32 BytesSent = 0;
+    Probe.SendTime = FPlatformTime::Seconds();
+    return Socket->SendTo(Request, LatencyProbeSize, BytesSent, *Probe.Resolver.GetAddress()) && BytesSent == LatencyProbeSize;
+}
+
+void FDriftLatencyProber::ReceiveReplies(TArray<TPair<FOnLatencyProbeComplete, int32>>& Completed)
+{
+    auto FromAddress = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+    uint8 Reply[64];
+    int32 BytesRead = 0;
+    while (Socket->RecvFrom(Reply, sizeof(Reply), BytesRead, *FromAddress) && BytesRead > 0)
+    {
+        if (BytesRead < LatencyProbeSize || ReadUInt32(Reply) != LatencyProbeMagic)
+        {
+            continue;
+        }
+
+        const uint32 Nonce = ReadUInt32(Reply + 4);
+        const int32 Index = InFlight.IndexOfByPredicate([Nonce](const FProbe& Probe)
+        {
+            return Probe.Nonce == Nonce && Probe.SendTime > 0.0;
+        });
+        if (Index != INDEX_NONE)
+        {
+            const double RoundTrip = FPlatformTime::Seconds() - InFlight[Index].SendTime;
+            Completed.Emplace(InFlight[Index].Delegate, FMath::Clamp(FMath::RoundToInt(RoundTrip * 1000.0), 0, MAX_QUERY_PING));
+            InFlight.RemoveAtSwap(Index);
+        }
+    }
+}
+
+
+FDriftLatencyEchoResponder::FDriftLatencyEchoResponder()
+{
+}
+
+FDriftLatencyEchoResponder::~FDriftLatencyEchoResponder()
+{
+    if (Socket)
+    {
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+        Socket = nullptr;
+    }
+}
+
+bool FDriftLatencyEchoResponder::Start()
+{
+    if (Socket)
+    {
+        return true;
+    }
+
+    int32 Port = 0;
+    GConfig->GetInt(DRIFT_CONFIG_SECTION, TEXT("LatencyProbePort"), Port, GEngineIni);
+    if (Port <= 0 || Port > MAX_uint16)
+    {
+        return false;
+    }
+
+    auto SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    auto Address = SocketSubsystem->CreateInternetAddr();
+    Address->SetAnyAddress();
+    Address->SetPort(Port);
+
+    Socket = SocketSubsystem->CreateSocket(NAME_DGram, TEXT("DriftLatencyEcho"), false);
+    if (Socket && (!Socket->SetNonBlocking(true) || !Socket->Bind(*Address)))
+    {
+        SocketSubsystem->DestroySocket(Socket);
+        Socket = nullptr;
+    }
+    if (Socket == nullptr)
+    {
+        UE_LOG_ONLINE(Warning, TEXT("Failed to listen for latency probes on port %d"), Port);
+        return false;
+    }
+
+    UE_LOG_ONLINE(Log, TEXT("Answering latency probes on port %d"), Port);
+    return true;
+}
+
+void FDriftLatencyEchoResponder::Tick(float DeltaTime)
+{
+    if (Socket == nullptr)
+    {
+        return;
+    }
+
+    auto FromAddress = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+    uint8 Request[64];
+    int32 BytesRead = 0;
+    for (int32 NumRead = 0; NumRead < MaxDatagramsPerTick && Socket->RecvFrom(Request, sizeof(Request), BytesRead, *FromAddress) && BytesRead > 0; ++NumRead)
+    {
+        if (BytesRead == LatencyProbeSize && ReadUInt32(Request) == LatencyProbeMagic)
+        {
+            int32 BytesSent = 0;
+            Socket->SendTo(Request, LatencyProbeSize, BytesSent, *FromAddress);
+        }
+    }
+}
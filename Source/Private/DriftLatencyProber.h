@@ -0,0 +1,118 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "IPAddress.h"
+#include "DriftHostResolver.h"
+
+class FSocket;
+
+
+/** Called with the measured round trip in milliseconds, or MAX_QUERY_PING if the host didn't answer */
+DECLARE_DELEGATE_OneParam(FOnLatencyProbeComplete, int32);
+
+
+/**
+ * Split a Drift connection url such as "10.0.0.1:7777" or "host.example.com:7777?opt" into host and port
+ *
+ * @return false if there is no host in the url
+ */
+bool DriftParseConnectionUrl(const FString& ConnectionUrl, FString& OutHost, int32& OutPort);
+
+
+/**
+ * Measures round trip times to game servers with a UDP echo
+ *
+ * Every probe sends one small datagram holding a nonce to the server and waits for it to come back.
+ * All probes share one non-blocking socket that is serviced from Tick(), so nothing ever blocks,
+ * and at most MaxInFlight probes are outstanding at any time, the rest wait their turn, first come first served.
+ *
+ * The game port doesn't answer probes, servers answer on LatencyProbePort with FDriftLatencyEchoResponder.
+ * Without a LatencyProbePort there's nobody to answer, IsEnabled() is false and probes fail right away.
+ *
+ * Tunables are read from the [OnlineSubsystemDrift] section of the engine ini:
+ * LatencyProbePort (0, the default, disables probing), LatencyProbeTimeout and LatencyProbeMaxInFlight.
+ */
+class FDriftLatencyProber
+{
+public:
+    FDriftLatencyProber();
+    ~FDriftLatencyProber();
+
+    /** @return false if no LatencyProbePort is configured */
+    bool IsEnabled() const { return ProbePort > 0; }
+
+    /**
+     * Queue a probe of the server in a connection url
+     *
+     * @param ConnectionUrl the ue4_connection_url of the server
+     * @param Delegate called from Tick() when the probe completes or times out
+     */
+    void Probe(const FString& ConnectionUrl, const FOnLatencyProbeComplete& Delegate);
+
+    void Tick(float DeltaTime);
+
+    bool IsIdle() const { return Pending.Num() == 0 && InFlight.Num() == 0; }
+
+private:
+    struct FProbe
+    {
+        FString Host;
+        int32 Port{ 0 };
+        FDriftHostResolver Resolver;
+        uint32 Nonce{ 0 };
+        /** When the probe was started, the timeout covers name resolution too */
+        double StartTime{ 0.0 };
+        /** When the echo request went out, 0 until then */
+        double SendTime{ 0.0 };
+        FOnLatencyProbeComplete Delegate;
+    };
+
+    bool CreateSocket();
+    /** Returns false if the probe can't go ahead */
+    bool StartProbe(FProbe& Probe);
+    bool SendEcho(FProbe& Probe);
+    void ReceiveReplies(TArray<TPair<FOnLatencyProbeComplete, int32>>& Completed);
+
+    int32 ProbePort{ 0 };
+    float Timeout{ 1.0f };
+    int32 MaxInFlight{ 16 };
+
+    FSocket* Socket{ nullptr };
+    uint32 NextNonce{ 1 };
+
+    /** Probes waiting for a free slot, oldest first */
+    TArray<FProbe> Pending;
+    /** Probes that are resolving their host or waiting for the echo */
+    TArray<FProbe> InFlight;
+};
+
+
+/**
+ * Answers the latency probes of FDriftLatencyProber, dedicated server only
+ *
+ * Listens on LatencyProbePort and sends every well formed probe straight back to where it came from.
+ * Only datagrams of exactly the probe size are answered, and at most MaxDatagramsPerTick are read per tick.
+ */
+class FDriftLatencyEchoResponder
+{
+public:
+    FDriftLatencyEchoResponder();
+    ~FDriftLatencyEchoResponder();
+
+    /**
+     * Start listening, LatencyProbePort from the [OnlineSubsystemDrift] ini section
+     *
+     * @return false if no port is configured or it can't be bound
+     */
+    bool Start();
+
+    void Tick(float DeltaTime);
+
+    bool IsListening() const { return Socket != nullptr; }
+
+private:
+    static const int32 MaxDatagramsPerTick = 64;
+
+    FSocket* Socket{ nullptr };
+};
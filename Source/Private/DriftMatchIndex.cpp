@@ -0,0 +1,71 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftMatchIndex.h"
+
+
+/** Single matches are rare, but don't let them pile up */
+static const int32 MaxSingleMatches = 64;
+
+
+FDriftMatchIndex::FDriftMatchIndex()
+{
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("MatchIndexMaxAge"), MaxAge, GEngineIni);
+}
+
+void FDriftMatchIndex::SetMatchList(const TSharedRef<FMatchesSearch>& Matches)
+{
+    MatchList = Matches;
+    MatchListTime = FPlatformTime::Seconds();
+
+    MatchListIndex.Reset();
+    MatchListIndex.Reserve(Matches->matches.Num());
+    for (int32 Index = 0; Index < Matches->matches.Num(); ++Index)
+    {
+        MatchListIndex.Add(Matches->matches[Index].match_id, Index);
+    }
+}
+
+void FDriftMatchIndex::Add(const FActiveMatch& Match)
+{
+    const double Now = FPlatformTime::Seconds();
+    if (SingleMatches.Num() >= MaxSingleMatches)
+    {
+        for (auto It = SingleMatches.CreateIterator(); It; ++It)
+        {
+            if (!IsFresh(It.Value().SeenTime))
+            {
+                It.RemoveCurrent();
+            }
+        }
+        if (SingleMatches.Num() >= MaxSingleMatches)
+        {
+            SingleMatches.Reset();
+        }
+    }
+    SingleMatches.Add(Match.match_id, FSeenMatch{ Match, Now });
+}
+
+const FActiveMatch* FDriftMatchIndex::Find(int32 MatchId) const
+{
+    if (const auto Single = SingleMatches.Find(MatchId))
+    {
+        if (IsFresh(Single->SeenTime))
+        {
+            return &Single->Match;
+        }
+    }
+    if (MatchList.IsValid() && IsFresh(MatchListTime))
+    {
+        if (const auto Index = MatchListIndex.Find(MatchId))
+        {
+            return &MatchList->matches[*Index];
+        }
+    }
+    return nullptr;
+}
+
+bool FDriftMatchIndex::IsFresh(double SeenTime) const
+{
+    return FPlatformTime::Seconds() - SeenTime < MaxAge;
+}
@@ -0,0 +1,46 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "DriftAPI.h"
+
+
+/**
+ * Recently seen matches, keyed by their backend match id
+ *
+ * The latest full match list is indexed in place, without copying its matches,
+ * and the few matches seen on their own, such as a matchmaking result, are kept alongside.
+ * Entries older than MatchIndexMaxAge seconds, from the [OnlineSubsystemDrift] ini section, are not returned.
+ */
+class FDriftMatchIndex
+{
+public:
+    FDriftMatchIndex();
+
+    /** Replace the indexed match list with a freshly fetched one */
+    void SetMatchList(const TSharedRef<FMatchesSearch>& Matches);
+
+    /** Remember a single match */
+    void Add(const FActiveMatch& Match);
+
+    /** @return the match if it was seen recently enough, nullptr otherwise */
+    const FActiveMatch* Find(int32 MatchId) const;
+
+private:
+    struct FSeenMatch
+    {
+        FActiveMatch Match;
+        double SeenTime;
+    };
+
+    bool IsFresh(double SeenTime) const;
+
+    float MaxAge{ 60.0f };
+
+    TSharedPtr<FMatchesSearch> MatchList;
+    double MatchListTime{ 0.0 };
+    /** Match id to index in MatchList */
+    TMap<int32, int32> MatchListIndex;
+
+    TMap<int32, FSeenMatch> SingleMatches;
+};
@@ -0,0 +1,46 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftMatchQuery.h"
+
+#include "DriftAPI.h"
+
+
+FDriftMatchQuery::FDriftMatchQuery(const FOnlineSessionSearch& SearchSettings)
+: MaxResults{ SearchSettings.MaxSearchResults }
+{
+    const auto& Query = SearchSettings.QuerySettings;
+    Query.Get(SETTING_MAPNAME, MapName);
+    Query.Get(SETTING_GAMEMODE, GameMode);
+    Query.Get(SETTING_REGION, Region);
+    Query.Get(SEARCH_MINSLOTSAVAILABLE, MinFreeSlots);
+    MinFreeSlots = FMath::Max(MinFreeSlots, 1);
+}
+
+bool FDriftMatchQuery::Matches(const FActiveMatch& Match) const
+{
+    if (!MapName.IsEmpty() && Match.map_name != MapName)
+    {
+        return false;
+    }
+    if (!GameMode.IsEmpty() && Match.game_mode != GameMode)
+    {
+        return false;
+    }
+    if (!Region.IsEmpty() && Match.placement != Region)
+    {
+        return false;
+    }
+    // Matches that don't report a player limit are never filtered on slots
+    if (MinFreeSlots > 0 && Match.max_players > 0 && Match.max_players - Match.num_players < MinFreeSlots)
+    {
+        return false;
+    }
+    return true;
+}
+
+FString FDriftMatchQuery::ToString() const
+{
+    return FString::Printf(TEXT("map=%s mode=%s region=%s minslots=%d max=%d"),
+        *MapName, *GameMode, *Region, MinFreeSlots, MaxResults);
+}
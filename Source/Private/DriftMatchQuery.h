@@ -0,0 +1,45 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineSessionSettings.h"
+
+struct FActiveMatch;
+
+
+/**
+ * Match filter built from the query settings of an FOnlineSessionSearch
+ *
+ * Understands SETTING_MAPNAME, SETTING_GAMEMODE, SETTING_REGION and SEARCH_MINSLOTSAVAILABLE,
+ * all compared with EOnlineComparisonOp::Equals except the slot count which is a minimum.
+ * Empty or missing settings don't filter anything, except that full matches are always left out,
+ * nobody can join them.
+ */
+struct FDriftMatchQuery
+{
+    FString MapName;
+    FString GameMode;
+    FString Region;
+    int32 MinFreeSlots{ 0 };
+
+    /** Stop after this many matching results */
+    int32 MaxResults{ 0 };
+
+    FDriftMatchQuery() {}
+
+    explicit FDriftMatchQuery(const FOnlineSessionSearch& SearchSettings);
+
+    /** @return true if the match passes every filter */
+    bool Matches(const FActiveMatch& Match) const;
+
+    bool operator==(const FDriftMatchQuery& Other) const
+    {
+        return MapName == Other.MapName
+            && GameMode == Other.GameMode
+            && Region == Other.Region
+            && MinFreeSlots == Other.MinFreeSlots
+            && MaxResults == Other.MaxResults;
+    }
+
+    FString ToString() const;
+};
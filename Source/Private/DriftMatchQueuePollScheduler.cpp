@@ -0,0 +1,61 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftMatchQueuePollScheduler.h"
+
+
+FMatchQueuePollScheduler::FMatchQueuePollScheduler()
+{
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("MatchQueueFastPollInterval"), FastPollInterval, GEngineIni);
+    GConfig->GetInt(DRIFT_CONFIG_SECTION, TEXT("MatchQueueFastPollCount"), FastPollCount, GEngineIni);
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("MatchQueuePollBackoff"), Backoff, GEngineIni);
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("MatchQueueMaxPollInterval"), MaxPollInterval, GEngineIni);
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("MatchQueuePollJitter"), JitterFraction, GEngineIni);
+
+    FastPollInterval = FMath::Max(FastPollInterval, 0.1f);
+    Backoff = FMath::Max(Backoff, 1.0f);
+    MaxPollInterval = FMath::Max(MaxPollInterval, FastPollInterval);
+    JitterFraction = FMath::Clamp(JitterFraction, 0.0f, 0.9f);
+}
+
+float FMatchQueuePollScheduler::Reset()
+{
+    Stats = FMatchQueuePollStats{};
+    CurrentInterval = FastPollInterval;
+    RetryAfter = 0.0f;
+    LastResponseTime = 0.0f;
+    return Jitter(CurrentInterval);
+}
+
+float FMatchQueuePollScheduler::OnPollComplete(bool bSuccess)
+{
+    LastResponseTime = Stats.TimeInQueue;
+
+    if (!bSuccess)
+    {
+        ++Stats.NumFailedPolls;
+        CurrentInterval = FMath::Min(CurrentInterval * 2.0f, MaxPollInterval);
+    }
+    else if (Stats.NumPolls >= FastPollCount)
+    {
+        CurrentInterval = FMath::Min(CurrentInterval * Backoff, MaxPollInterval);
+    }
+
+    float Delay = Jitter(CurrentInterval);
+    if (RetryAfter > Delay)
+    {
+        Delay = RetryAfter;
+    }
+    RetryAfter = 0.0f;
+    return Delay;
+}
+
+void FMatchQueuePollScheduler::OnMatchDetected(bool bWasPushed)
+{
+    Stats.MatchDetectionWindow = bWasPushed ? 0.0f : Stats.TimeInQueue - LastResponseTime;
+}
+
+float FMatchQueuePollScheduler::Jitter(float Interval) const
+{
+    return Interval * (1.0f + FMath::FRandRange(-JitterFraction, JitterFraction));
+}
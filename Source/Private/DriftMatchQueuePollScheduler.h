@@ -0,0 +1,86 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+
+/**
+ * Counters describing how a match queue was polled
+ */
+struct FMatchQueuePollStats
+{
+    /** Polls sent while in the queue */
+    int32 NumPolls{ 0 };
+
+    /** Polls that failed, these back off harder */
+    int32 NumFailedPolls{ 0 };
+
+    /** Seconds since joining the queue */
+    float TimeInQueue{ 0.0f };
+
+    /**
+     * Upper bound on how long the match existed before we noticed,
+     * i.e. the time between the last two poll responses when the match was found
+     */
+    float MatchDetectionWindow{ 0.0f };
+};
+
+
+/**
+ * Decides how long to wait between match queue polls.
+ *
+ * Polls quickly right after joining, when a match is most likely, then backs off exponentially
+ * towards a ceiling while waiting. Every delay is jittered so clients that joined together
+ * don't keep polling in lockstep, and a retry-after hint from the server always wins if it is longer.
+ *
+ * Tunables are read from the [OnlineSubsystemDrift] section of the engine ini:
+ * MatchQueueFastPollInterval, MatchQueueFastPollCount, MatchQueuePollBackoff,
+ * MatchQueueMaxPollInterval and MatchQueuePollJitter.
+ */
+class FMatchQueuePollScheduler
+{
+public:
+    FMatchQueuePollScheduler();
+
+    /** Start over for a freshly joined queue, returns the delay before the first poll */
+    float Reset();
+
+    /**
+     * Record a poll response and decide when to poll next
+     *
+     * @param bSuccess whether the poll succeeded, failures back off twice as fast
+     * @return seconds to wait before the next poll
+     */
+    float OnPollComplete(bool bSuccess);
+
+    /** Record that a poll was sent */
+    void OnPollSent() { ++Stats.NumPolls; }
+
+    /** Ask for the next poll to wait at least this long, as instructed by the server */
+    void SetRetryAfter(float Seconds) { RetryAfter = FMath::Max(RetryAfter, Seconds); }
+
+    void Tick(float DeltaTime) { Stats.TimeInQueue += DeltaTime; }
+
+    /**
+     * Record that a match was detected, at the current time in queue
+     *
+     * @param bWasPushed the backend pushed the match to us, so there was no polling delay
+     */
+    void OnMatchDetected(bool bWasPushed);
+
+    const FMatchQueuePollStats& GetStats() const { return Stats; }
+
+private:
+    float Jitter(float Interval) const;
+
+    float FastPollInterval{ 1.0f };
+    int32 FastPollCount{ 3 };
+    float Backoff{ 1.5f };
+    float MaxPollInterval{ 15.0f };
+    float JitterFraction{ 0.2f };
+
+    float CurrentInterval{ 0.0f };
+    float RetryAfter{ 0.0f };
+    float LastResponseTime{ 0.0f };
+
+    FMatchQueuePollStats Stats;
+};
@@ -0,0 +1,80 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftMatchQueueTicket.h"
+
+#include "DriftAPI.h"
+
+
+FDriftMatchQueueTicket::FDriftMatchQueueTicket(const TArray<TSharedRef<const FUniqueNetId>>& LocalPlayers, const FOnlineSessionSettings& NewSessionSettings)
+: SessionSettings(NewSessionSettings)
+{
+    Players.Reserve(LocalPlayers.Num());
+    for (const auto& Player : LocalPlayers)
+    {
+        FUniqueNetIdMatcher PlayerMatch(*Player);
+        if (Players.IndexOfByPredicate(PlayerMatch) == INDEX_NONE)
+        {
+            Players.Add(Player);
+        }
+    }
+
+    SessionSettings.Get(SETTING_MAPNAME, Query.MapName);
+    SessionSettings.Get(SETTING_GAMEMODE, Query.GameMode);
+    SessionSettings.Get(SETTING_REGION, Query.Region);
+    Query.MinFreeSlots = Players.Num();
+}
+
+bool FDriftMatchQueueTicket::Validate(FString& OutError) const
+{
+    // No connection counts means the group doesn't care about the session size
+    const int32 Capacity = SessionSettings.NumPublicConnections + SessionSettings.NumPrivateConnections;
+    if (Capacity > 0 && Players.Num() > Capacity)
+    {
+        OutError = FString::Printf(TEXT("%d players don't fit in a session with %d connections"), Players.Num(), Capacity);
+        return false;
+    }
+    return true;
+}
+
+bool FDriftMatchQueueTicket::Fits(const FActiveMatch& Match) const
+{
+    FDriftMatchQuery MatchedQuery = Query;
+    MatchedQuery.MinFreeSlots = 0;
+    return MatchedQuery.Matches(Match);
+}
+
+void FDriftMatchQueueTicket::ApplyTo(FOnlineSessionSettings& MatchSettings, const FActiveMatch& Match) const
+{
+    const TPair<FName, FString> MatchValues[] =
+    {
+        TPair<FName, FString>(SETTING_MAPNAME, Match.map_name),
+        TPair<FName, FString>(SETTING_GAMEMODE, Match.game_mode),
+        TPair<FName, FString>(SETTING_REGION, Match.placement),
+    };
+    for (const auto& MatchValue : MatchValues)
+    {
+        if (!MatchValue.Value.IsEmpty())
+        {
+            MatchSettings.Set(MatchValue.Key, MatchValue.Value, EOnlineDataAdvertisementType::ViaOnlineService);
+        }
+    }
+
+    // The connection counts and the like come from the match, only what the group asked for is copied
+    for (const auto& Setting : SessionSettings.Settings)
+    {
+        if (!MatchSettings.Settings.Contains(Setting.Key))
+        {
+            MatchSettings.Settings.Add(Setting.Key, Setting.Value);
+        }
+    }
+    MatchSettings.bUsesPresence = SessionSettings.bUsesPresence;
+    MatchSettings.bAllowInvites = SessionSettings.bAllowInvites;
+    MatchSettings.bAllowJoinViaPresence = SessionSettings.bAllowJoinViaPresence;
+    MatchSettings.bAllowJoinViaPresenceFriendsOnly = SessionSettings.bAllowJoinViaPresenceFriendsOnly;
+}
+
+FString FDriftMatchQueueTicket::ToString() const
+{
+    return FString::Printf(TEXT("players=%d %s"), Players.Num(), *Query.ToString());
+}
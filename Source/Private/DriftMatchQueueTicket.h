@@ -0,0 +1,50 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineSessionSettings.h"
+#include "DriftMatchQuery.h"
+
+
+/**
+ * Everything StartMatchmaking was given, as one entry in the match queue
+ *
+ * The players queue as a group and are matched together, so the match has to have room for all of them.
+ * The session settings describe the session the group wants: the map, mode and region settings
+ * become the query the match is checked against, and the settings the match doesn't define are
+ * carried over to the session created for the match.
+ */
+struct FDriftMatchQueueTicket
+{
+    /** Everyone queueing together, without duplicates */
+    TArray<TSharedRef<const FUniqueNetId>> Players;
+
+    FOnlineSessionSettings SessionSettings;
+
+    /** SessionSettings as a match filter for searching, needing a free slot for every player */
+    FDriftMatchQuery Query;
+
+    FDriftMatchQueueTicket() {}
+
+    FDriftMatchQueueTicket(const TArray<TSharedRef<const FUniqueNetId>>& LocalPlayers, const FOnlineSessionSettings& NewSessionSettings);
+
+    /**
+     * @param OutError why the ticket can't be queued
+     * @return true if the group fits the session it asks for
+     */
+    bool Validate(FString& OutError) const;
+
+    /**
+     * @return true if the match the group was placed in is what it asked for
+     * The group already counts towards the match's players, so free slots aren't checked
+     */
+    bool Fits(const FActiveMatch& Match) const;
+
+    /**
+     * Fill in the session of a match the group was placed in
+     * The map, mode and region are the match's, the group's settings only fill in the keys the match doesn't define
+     */
+    void ApplyTo(FOnlineSessionSettings& MatchSettings, const FActiveMatch& Match) const;
+
+    FString ToString() const;
+};
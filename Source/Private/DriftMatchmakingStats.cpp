@@ -0,0 +1,198 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftMatchmakingStats.h"
+#include "DriftMatchQueuePollScheduler.h"
+
+
+DECLARE_STATS_GROUP(TEXT("DriftMatchmaking"), STATGROUP_DriftMatchmaking, STATCAT_Advanced);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Matchmaking Started"), STAT_DriftMatchmakingStarted, STATGROUP_DriftMatchmaking);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Matchmaking Matched"), STAT_DriftMatchmakingMatched, STATGROUP_DriftMatchmaking);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Matchmaking Failed"), STAT_DriftMatchmakingFailed, STATGROUP_DriftMatchmaking);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Matchmaking Cancelled"), STAT_DriftMatchmakingCancelled, STATGROUP_DriftMatchmaking);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Time To Queue (ms)"), STAT_DriftMatchmakingTimeToQueue, STATGROUP_DriftMatchmaking);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Time In Queue (s)"), STAT_DriftMatchmakingTimeInQueue, STATGROUP_DriftMatchmaking);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Poll Round Trip (ms)"), STAT_DriftMatchmakingPollRoundTrip, STATGROUP_DriftMatchmaking);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Polls Per Match"), STAT_DriftMatchmakingPollsPerMatch, STATGROUP_DriftMatchmaking);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Matched To Join (ms)"), STAT_DriftMatchmakingMatchedToJoin, STATGROUP_DriftMatchmaking);
+
+
+FDriftHistogram::FDriftHistogram(float InFirstBucketLimit)
+: FirstBucketLimit(InFirstBucketLimit)
+{
+    Reset();
+}
+
+void FDriftHistogram::Add(float Value)
+{
+    int32 Bucket = 0;
+    float Limit = FirstBucketLimit;
+    while (Value > Limit && Bucket < NumBuckets - 1)
+    {
+        Limit *= 2.0f;
+        ++Bucket;
+    }
+    ++Buckets[Bucket];
+    ++Count;
+    Sum += Value;
+    Max = FMath::Max(Max, Value);
+}
+
+void FDriftHistogram::Reset()
+{
+    FMemory::Memzero(Buckets);
+    Count = 0;
+    Sum = 0.0;
+    Max = 0.0f;
+}
+
+float FDriftHistogram::GetPercentile(float Fraction) const
+{
+    const int32 Wanted = FMath::CeilToInt(Count * FMath::Clamp(Fraction, 0.0f, 1.0f));
+    int32 Seen = 0;
+    for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+    {
+        Seen += Buckets[Bucket];
+        if (Seen >= Wanted && Seen > 0)
+        {
+            // The overflow bucket has no upper limit, the maximum is the best we know
+            return Bucket == NumBuckets - 1 ? Max : FMath::Min(GetBucketLimit(Bucket), Max);
+        }
+    }
+    return 0.0f;
+}
+
+FString FDriftHistogram::ToString(float Scale) const
+{
+    FString Result = FString::Printf(TEXT("n=%d mean=%.1f p50=%.1f p90=%.1f p99=%.1f max=%.1f |"),
+        Count, GetMean() * Scale, GetPercentile(0.5f) * Scale, GetPercentile(0.9f) * Scale, GetPercentile(0.99f) * Scale, Max * Scale);
+    for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+    {
+        if (Buckets[Bucket] > 0)
+        {
+            Result += FString::Printf(TEXT(" <=%g:%d"), GetBucketLimit(Bucket) * Scale, Buckets[Bucket]);
+        }
+    }
+    return Result;
+}
+
+float FDriftHistogram::GetBucketLimit(int32 Bucket) const
+{
+    return FirstBucketLimit * static_cast<float>(1 << Bucket);
+}
+
+
+FDriftMatchmakingStats::FDriftMatchmakingStats()
+: TimeToQueue(0.05f)
+, TimeInQueue(1.0f)
+, PollRoundTrip(0.025f)
+, PollsPerMatch(1.0f)
+, MatchedToJoin(0.05f)
+{
+}
+
+void FDriftMatchmakingStats::OnStarted()
+{
+    StartTime = FPlatformTime::Seconds();
+    QueueJoinTime = 0.0;
+    MatchedTime = 0.0;
+    ++NumStarted;
+    PublishCounters();
+}
+
+void FDriftMatchmakingStats::OnJoinedQueue(bool bSuccess)
+{
+    if (StartTime == 0.0)
+    {
+        return;
+    }
+    QueueJoinTime = FPlatformTime::Seconds();
+    if (bSuccess)
+    {
+        const float Elapsed = static_cast<float>(QueueJoinTime - StartTime);
+        TimeToQueue.Add(Elapsed);
+        SET_FLOAT_STAT(STAT_DriftMatchmakingTimeToQueue, Elapsed * 1000.0f);
+    }
+}
+
+void FDriftMatchmakingStats::OnPollComplete(float RoundTripTime)
+{
+    PollRoundTrip.Add(RoundTripTime);
+    SET_FLOAT_STAT(STAT_DriftMatchmakingPollRoundTrip, RoundTripTime * 1000.0f);
+}
+
+void FDriftMatchmakingStats::OnMatched(const FMatchQueuePollStats& PollStats)
+{
+    MatchedTime = FPlatformTime::Seconds();
+    ++NumMatched;
+    if (QueueJoinTime > 0.0)
+    {
+        const float Elapsed = static_cast<float>(MatchedTime - QueueJoinTime);
+        TimeInQueue.Add(Elapsed);
+        SET_FLOAT_STAT(STAT_DriftMatchmakingTimeInQueue, Elapsed);
+    }
+    PollsPerMatch.Add(static_cast<float>(PollStats.NumPolls));
+    SET_DWORD_STAT(STAT_DriftMatchmakingPollsPerMatch, PollStats.NumPolls);
+    StartTime = 0.0;
+    PublishCounters();
+}
+
+void FDriftMatchmakingStats::OnFailed()
+{
+    ++NumFailed;
+    StartTime = 0.0;
+    PublishCounters();
+}
+
+void FDriftMatchmakingStats::OnCancelled()
+{
+    ++NumCancelled;
+    StartTime = 0.0;
+    PublishCounters();
+}
+
+void FDriftMatchmakingStats::OnSessionJoined()
+{
+    if (MatchedTime == 0.0)
+    {
+        // Not joining a match we were placed in
+        return;
+    }
+    const float Elapsed = static_cast<float>(FPlatformTime::Seconds() - MatchedTime);
+    MatchedToJoin.Add(Elapsed);
+    SET_FLOAT_STAT(STAT_DriftMatchmakingMatchedToJoin, Elapsed * 1000.0f);
+    MatchedTime = 0.0;
+}
+
+void FDriftMatchmakingStats::Dump(FOutputDevice& Ar) const
+{
+    Ar.Logf(TEXT("Matchmaking: started=%d matched=%d failed=%d cancelled=%d"), NumStarted, NumMatched, NumFailed, NumCancelled);
+    Ar.Logf(TEXT("  Time to queue (ms): %s"), *TimeToQueue.ToString(1000.0f));
+    Ar.Logf(TEXT("  Time in queue (s): %s"), *TimeInQueue.ToString());
+    Ar.Logf(TEXT("  Poll round trip (ms): %s"), *PollRoundTrip.ToString(1000.0f));
+    Ar.Logf(TEXT("  Polls per match: %s"), *PollsPerMatch.ToString());
+    Ar.Logf(TEXT("  Matched to join (ms): %s"), *MatchedToJoin.ToString(1000.0f));
+}
+
+void FDriftMatchmakingStats::Reset()
+{
+    TimeToQueue.Reset();
+    TimeInQueue.Reset();
+    PollRoundTrip.Reset();
+    PollsPerMatch.Reset();
+    MatchedToJoin.Reset();
+    NumStarted = 0;
+    NumMatched = 0;
+    NumFailed = 0;
+    NumCancelled = 0;
+    PublishCounters();
+}
+
+void FDriftMatchmakingStats::PublishCounters() const
+{
+    SET_DWORD_STAT(STAT_DriftMatchmakingStarted, NumStarted);
+    SET_DWORD_STAT(STAT_DriftMatchmakingMatched, NumMatched);
+    SET_DWORD_STAT(STAT_DriftMatchmakingFailed, NumFailed);
+    SET_DWORD_STAT(STAT_DriftMatchmakingCancelled, NumCancelled);
+}
@@ -0,0 +1,86 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+struct FMatchQueuePollStats;
+
+
+/**
+ * Fixed size histogram with exponentially growing buckets
+ *
+ * Bucket 0 holds values up to FirstBucketLimit, each following bucket twice the range of the one before,
+ * and the last one everything above. Adding a value is a handful of instructions and never allocates.
+ */
+class FDriftHistogram
+{
+public:
+    static const int32 NumBuckets = 16;
+
+    explicit FDriftHistogram(float InFirstBucketLimit);
+
+    void Add(float Value);
+    void Reset();
+
+    int32 GetCount() const { return Count; }
+    float GetMean() const { return Count > 0 ? static_cast<float>(Sum / Count) : 0.0f; }
+    float GetMax() const { return Max; }
+
+    /** @return upper limit of the bucket holding the given fraction of values, e.g. 0.5 for the median */
+    float GetPercentile(float Fraction) const;
+
+    /** Summary line, values are multiplied by Scale, e.g. 1000 for seconds to milliseconds */
+    FString ToString(float Scale = 1.0f) const;
+
+private:
+    float GetBucketLimit(int32 Bucket) const;
+
+    float FirstBucketLimit;
+    int32 Buckets[NumBuckets];
+    int32 Count;
+    double Sum;
+    float Max;
+};
+
+
+/**
+ * Where time goes between StartMatchmaking and being in a match
+ *
+ * Phases are timed as: StartMatchmaking until the backend put us in the queue, time spent in the queue,
+ * the round trip of every queue poll, polls needed per match, and the time from being matched until the
+ * game joins the session. Latest values and counters are published to STATGROUP_DriftMatchmaking
+ * ("stat DriftMatchmaking"), the histograms are dumped with "MATCHQUEUE STATS".
+ */
+class FDriftMatchmakingStats
+{
+public:
+    FDriftMatchmakingStats();
+
+    void OnStarted();
+    void OnJoinedQueue(bool bSuccess);
+    void OnPollComplete(float RoundTripTime);
+    void OnMatched(const FMatchQueuePollStats& PollStats);
+    void OnFailed();
+    void OnCancelled();
+    void OnSessionJoined();
+
+    void Dump(FOutputDevice& Ar) const;
+    void Reset();
+
+private:
+    void PublishCounters() const;
+
+    double StartTime{ 0.0 };
+    double QueueJoinTime{ 0.0 };
+    double MatchedTime{ 0.0 };
+
+    FDriftHistogram TimeToQueue;
+    FDriftHistogram TimeInQueue;
+    FDriftHistogram PollRoundTrip;
+    FDriftHistogram PollsPerMatch;
+    FDriftHistogram MatchedToJoin;
+
+    int32 NumStarted{ 0 };
+    int32 NumMatched{ 0 };
+    int32 NumFailed{ 0 };
+    int32 NumCancelled{ 0 };
+};
@@ -0,0 +1,151 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftPlayerRegistrationBatcher.h"
+#include "OnlineSubsystemDrift.h"
+
+#include "DriftAPI.h"
+
+
+FDriftPlayerRegistrationBatcher::FDriftPlayerRegistrationBatcher(FOnlineSubsystemDrift* InSubsystem)
+: DriftSubsystem(InSubsystem)
+{
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("PlayerRegistrationBatchWindow"), BatchWindow, GEngineIni);
+}
+
+void FDriftPlayerRegistrationBatcher::Queue(const TArray<DriftID>& PlayerIds, bool bAdd, TFunction<void(bool)> OnComplete)
+{
+    TSharedRef<FBatch> Batch = MakeShareable(new FBatch{});
+    Batch->OnComplete = MoveTemp(OnComplete);
+
+    if (QueuedChanges.Num() == 0)
+    {
+        TimeUntilFlush = BatchWindow;
+    }
+
+    for (const auto PlayerId : PlayerIds)
+    {
+        if (auto Existing = QueuedChanges.Find(PlayerId))
+        {
+            if (Existing->bAdd != bAdd)
+            {
+                // The earlier change never reached the backend, so neither needs to
+                auto Cancelled = MoveTemp(Existing->Batches);
+                QueuedChanges.Remove(PlayerId);
+                for (const auto& CancelledBatch : Cancelled)
+                {
+                    CompleteOne(CancelledBatch, true);
+                }
+            }
+            else
+            {
+                Existing->Batches.Add(Batch);
+                ++Batch->NumOutstanding;
+            }
+            continue;
+        }
+
+        auto& Change = QueuedChanges.Add(PlayerId);
+        Change.bAdd = bAdd;
+        Change.Batches.Add(Batch);
+        ++Batch->NumOutstanding;
+    }
+
+    if (Batch->NumOutstanding == 0 && Batch->OnComplete)
+    {
+        Batch->OnComplete(true);
+    }
+}
+
+void FDriftPlayerRegistrationBatcher::Tick(float DeltaTime)
+{
+    if (QueuedChanges.Num() > 0)
+    {
+        TimeUntilFlush -= DeltaTime;
+        if (TimeUntilFlush <= 0.0f)
+        {
+            Flush();
+        }
+    }
+}
+
+void FDriftPlayerRegistrationBatcher::Flush()
+{
+    if (QueuedChanges.Num() == 0)
+    {
+        return;
+    }
+
+    // Completions may queue more changes, those go into the next batch
+    auto Changes = MoveTemp(QueuedChanges);
+    QueuedChanges.Reset();
+
+    auto Drift = DriftSubsystem->GetDrift();
+    UE_LOG_ONLINE(Verbose, TEXT("Sending %d match player updates to Drift"), Changes.Num());
+
+    SentBatches.RemoveAll([](const TWeakPtr<FBatch>& Batch)
+    {
+        return !Batch.IsValid();
+    });
+
+    for (auto& Change : Changes)
+    {
+        TArray<TSharedRef<FBatch>> Batches = MoveTemp(Change.Value.Batches);
+        if (Drift == nullptr)
+        {
+            for (const auto& Batch : Batches)
+            {
+                CompleteOne(Batch, false);
+            }
+            continue;
+        }
+
+        for (const auto& Batch : Batches)
+        {
+            SentBatches.AddUnique(Batch);
+        }
+        auto OnChangeComplete = [Batches](bool success)
+        {
+            for (const auto& Batch : Batches)
+            {
+                CompleteOne(Batch, success);
+            }
+        };
+        if (Change.Value.bAdd)
+        {
+            Drift->AddPlayerToMatch(Change.Key, 0, FDriftPlayerAddedDelegate::CreateLambda(OnChangeComplete));
+        }
+        else
+        {
+            Drift->RemovePlayerFromMatch(Change.Key, FDriftPlayerRemovedDelegate::CreateLambda(OnChangeComplete));
+        }
+    }
+}
+
+void FDriftPlayerRegistrationBatcher::Shutdown()
+{
+    Flush();
+
+    // Answers that arrive after this find nothing left to call
+    auto Outstanding = MoveTemp(SentBatches);
+    SentBatches.Reset();
+    for (const auto& WeakBatch : Outstanding)
+    {
+        auto Batch = WeakBatch.Pin();
+        if (Batch.IsValid() && Batch->NumOutstanding > 0 && Batch->OnComplete)
+        {
+            auto OnComplete = MoveTemp(Batch->OnComplete);
+            Batch->OnComplete = nullptr;
+            OnComplete(Batch->bSuccess);
+        }
+    }
+}
+
+void FDriftPlayerRegistrationBatcher::CompleteOne(const TSharedRef<FBatch>& Batch, bool bSuccess)
+{
+    Batch->bSuccess &= bSuccess;
+    if (--Batch->NumOutstanding == 0 && Batch->OnComplete)
+    {
+        Batch->OnComplete(Batch->bSuccess);
+    }
+}
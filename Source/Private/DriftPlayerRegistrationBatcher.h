@@ -0,0 +1,72 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineSubsystemDriftTypes.h"
+
+class FOnlineSubsystemDrift;
+
+
+/**
+ * Coalesces match player updates from a dedicated server
+ *
+ * Player additions and removals are held for a short window, PlayerRegistrationBatchWindow seconds
+ * from the [OnlineSubsystemDrift] ini section, and then sent together. A removal queued for a player
+ * whose addition hasn't been sent yet, or the other way around, cancels out and is never sent.
+ * Every Queue() call gets exactly one completion, once all of its players have been dealt with.
+ */
+class FDriftPlayerRegistrationBatcher
+{
+public:
+    FDriftPlayerRegistrationBatcher(FOnlineSubsystemDrift* InSubsystem);
+
+    /**
+     * Queue players to be added to, or removed from, the current match
+     *
+     * @param PlayerIds players to update
+     * @param bAdd true to add the players, false to remove them
+     * @param OnComplete called once with the combined result, possibly before Queue() returns
+     */
+    void Queue(const TArray<DriftID>& PlayerIds, bool bAdd, TFunction<void(bool)> OnComplete);
+
+    void Tick(float DeltaTime);
+
+    /** Send everything queued right away */
+    void Flush();
+
+    /**
+     * Send everything queued and complete every outstanding Queue() call without waiting for Drift,
+     * nobody is around to hear its answers once the server shuts down.
+     * Completions report whether the players' updates could be sent.
+     */
+    void Shutdown();
+
+    /** Players with a change waiting to be sent */
+    int32 NumQueued() const { return QueuedChanges.Num(); }
+
+private:
+    struct FBatch
+    {
+        TFunction<void(bool)> OnComplete;
+        int32 NumOutstanding{ 0 };
+        bool bSuccess{ true };
+    };
+
+    struct FQueuedChange
+    {
+        bool bAdd;
+        TArray<TSharedRef<FBatch>> Batches;
+    };
+
+    static void CompleteOne(const TSharedRef<FBatch>& Batch, bool bSuccess);
+
+    FOnlineSubsystemDrift* DriftSubsystem;
+
+    /** Batches sent to Drift, which may not have answered yet */
+    TArray<TWeakPtr<FBatch>> SentBatches;
+
+    float BatchWindow{ 0.1f };
+    float TimeUntilFlush{ 0.0f };
+
+    TMap<DriftID, FQueuedChange> QueuedChanges;
+};
@@ -0,0 +1,181 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftQuickJoin.h"
+#include "OnlineSessionDrift.h"
+
+
+FDriftQuickJoin::FDriftQuickJoin(FOnlineSessionDrift& InSessionInt, int32 InPlayerNum, FName InSessionName,
+    const TSharedRef<FOnlineSessionSearch>& InSearchSettings, const FOnQuickJoinCompleteDelegate& InCompletionDelegate)
+: SessionInt(InSessionInt)
+, PlayerNum(InPlayerNum)
+, SessionName(InSessionName)
+, SearchSettings(InSearchSettings)
+, CompletionDelegate(InCompletionDelegate)
+{
+    GConfig->GetInt(DRIFT_CONFIG_SECTION, TEXT("QuickJoinPingCandidates"), NumToPing, GEngineIni);
+}
+
+FDriftQuickJoin::~FDriftQuickJoin()
+{
+    SessionInt.OnSearchResultsPinged().Remove(OnPingedHandle);
+    SessionInt.OnSearchResultsRanked().Remove(OnRankedHandle);
+}
+
+bool FDriftQuickJoin::Start()
+{
+    StartTime = FPlatformTime::Seconds();
+    StageStartTime = StartTime;
+
+    OnPingedHandle = SessionInt.OnSearchResultsPinged().AddRaw(this, &FDriftQuickJoin::OnPinged);
+    OnRankedHandle = SessionInt.OnSearchResultsRanked().AddRaw(this, &FDriftQuickJoin::OnRanked);
+
+    if (!SessionInt.FindSessions(PlayerNum, SearchSettings))
+    {
+        Complete(EOnJoinSessionCompleteResult::UnknownError);
+        return false;
+    }
+    return true;
+}
+
+void FDriftQuickJoin::Fail(EOnJoinSessionCompleteResult::Type InResult)
+{
+    StartTime = FPlatformTime::Seconds();
+    StageStartTime = StartTime;
+    Complete(InResult);
+}
+
+bool FDriftQuickJoin::Tick()
+{
+    switch (Stage)
+    {
+    case EStage::Searching:
+        if (SearchSettings->SearchState != EOnlineAsyncTaskState::InProgress)
+        {
+            OnSearchComplete();
+        }
+        break;
+    case EStage::Joining:
+        OnJoined();
+        break;
+    default:
+        break;
+    }
+    return Stage == EStage::Done;
+}
+
+void FDriftQuickJoin::TriggerDelegates()
+{
+    UE_LOG_ONLINE(Log, TEXT("Quick join of session (%s) %s: %s"),
+        *SessionName.ToString(), Result == EOnJoinSessionCompleteResult::Success ? TEXT("succeeded") : TEXT("failed"), *Timings.ToString());
+    CompletionDelegate.ExecuteIfBound(SessionName, Result, ConnectString, Timings);
+}
+
+void FDriftQuickJoin::OnSearchComplete()
+{
+    Timings.NumResults = SearchSettings->SearchResults.Num();
+    if (SearchSettings->SearchState != EOnlineAsyncTaskState::Done)
+    {
+        Complete(EOnJoinSessionCompleteResult::UnknownError);
+    }
+    else if (Timings.NumResults == 0)
+    {
+        Complete(EOnJoinSessionCompleteResult::SessionDoesNotExist);
+    }
+    else
+    {
+        EnterStage(EStage::Pinging, Timings.Search);
+        if (NumToPing <= 0 || !SessionInt.PingSearchResults(SearchSettings, 0, FMath::Min(NumToPing, Timings.NumResults)))
+        {
+            // Nothing to wait for, rank on what the search knows
+            Timings.NumReachable = Timings.NumResults;
+            EnterStage(EStage::Ranking, Timings.Ping);
+            SessionInt.RankSearchResults(SearchSettings, 1);
+        }
+    }
+}
+
+void FDriftQuickJoin::OnPinged(const TSharedRef<FOnlineSessionSearch>& PingedSearch)
+{
+    if (Stage != EStage::Pinging || PingedSearch != SearchSettings)
+    {
+        return;
+    }
+
+    // Results that didn't answer, or weren't pinged, rank after those that did, but stay candidates
+    Timings.NumReachable = 0;
+    for (const auto& SearchResult : SearchSettings->SearchResults)
+    {
+        if (SearchResult.PingInMs < MAX_QUERY_PING)
+        {
+            ++Timings.NumReachable;
+        }
+    }
+
+    // Order every reachable result, the join falls back to the next one if the best filled up
+    EnterStage(EStage::Ranking, Timings.Ping);
+    SessionInt.RankSearchResults(SearchSettings, FMath::Max(Timings.NumReachable, 1));
+}
+
+void FDriftQuickJoin::OnRanked(const TSharedRef<FOnlineSessionSearch>& RankedSearch, int32 NumRanked)
+{
+    if (Stage != EStage::Ranking || RankedSearch != SearchSettings)
+    {
+        return;
+    }
+
+    EnterStage(EStage::Joining, Timings.Rank);
+
+    // The best first, and if it filled up since the search, the next one that still has room
+    const auto Candidate = SearchSettings->SearchResults.FindByPredicate([this](const FOnlineSessionSearchResult& SearchResult)
+    {
+        return !SessionInt.IsSearchResultFull(SearchResult);
+    });
+    if (Candidate == nullptr)
+    {
+        Complete(EOnJoinSessionCompleteResult::SessionIsFull);
+        return;
+    }
+    if (!SessionInt.JoinSession(PlayerNum, SessionName, *Candidate))
+    {
+        Complete(EOnJoinSessionCompleteResult::AlreadyInSession);
+        return;
+    }
+    // The join task may have run already
+    OnJoined();
+}
+
+void FDriftQuickJoin::OnJoined()
+{
+    const auto State = SessionInt.GetSessionState(SessionName);
+    if (State == EOnlineSessionState::NoSession && SessionInt.GetNamedSession(SessionName) == nullptr)
+    {
+        Complete(EOnJoinSessionCompleteResult::UnknownError);
+    }
+    else if (State == EOnlineSessionState::Pending)
+    {
+        Complete(SessionInt.GetResolvedConnectString(SessionName, ConnectString)
+            ? EOnJoinSessionCompleteResult::Success
+            : EOnJoinSessionCompleteResult::CouldNotRetrieveAddress);
+    }
+}
+
+void FDriftQuickJoin::EnterStage(EStage NewStage, float& StageTime)
+{
+    const double Now = FPlatformTime::Seconds();
+    StageTime = static_cast<float>(Now - StageStartTime);
+    StageStartTime = Now;
+    Stage = NewStage;
+}
+
+void FDriftQuickJoin::Complete(EOnJoinSessionCompleteResult::Type InResult)
+{
+    const double Now = FPlatformTime::Seconds();
+    if (Stage == EStage::Joining)
+    {
+        Timings.Join = static_cast<float>(Now - StageStartTime);
+    }
+    Timings.Total = static_cast<float>(Now - StartTime);
+    Result = InResult;
+    Stage = EStage::Done;
+}
@@ -0,0 +1,78 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineSessionInterfaceDrift.h"
+
+class FOnlineSessionDrift;
+
+
+/**
+ * Search, ping, rank, join and resolve as one operation, see IOnlineSessionDrift::QuickJoin
+ *
+ * Every stage starts from the callback of the one before, so there is no waiting for the next tick in between.
+ * Drift can't reserve a slot, so full matches are filtered out by the search and skipped again when joining,
+ * in case they filled up in the meantime. Servers that don't answer the ping rank after those that do, they are only
+ * joined if every server that answered is full. The first QuickJoinPingCandidates results are pinged, read from the
+ * [OnlineSubsystemDrift] ini section, 0 by default, which ranks on what the search knows without pinging.
+ */
+class FDriftQuickJoin
+{
+public:
+    FDriftQuickJoin(FOnlineSessionDrift& InSessionInt, int32 InPlayerNum, FName InSessionName,
+        const TSharedRef<FOnlineSessionSearch>& InSearchSettings, const FOnQuickJoinCompleteDelegate& InCompletionDelegate);
+    ~FDriftQuickJoin();
+
+    /** @return false if the search couldn't be started, the quick join is then already complete */
+    bool Start();
+
+    /** Complete without starting, the owner reports it on its next tick like any other outcome */
+    void Fail(EOnJoinSessionCompleteResult::Type InResult);
+
+    bool IsDone() const { return Stage == EStage::Done; }
+
+    /** @return true once complete, the owner then calls TriggerDelegates() and deletes it */
+    bool Tick();
+
+    void TriggerDelegates();
+
+    FName GetSessionName() const { return SessionName; }
+
+private:
+    enum class EStage
+    {
+        Searching,
+        Pinging,
+        Ranking,
+        Joining,
+        Done,
+    };
+
+    void OnSearchComplete();
+    void OnPinged(const TSharedRef<FOnlineSessionSearch>& PingedSearch);
+    void OnRanked(const TSharedRef<FOnlineSessionSearch>& RankedSearch, int32 NumRanked);
+    void OnJoined();
+
+    /** Move on to the next stage, charging the time spent to the one that ended */
+    void EnterStage(EStage NewStage, float& StageTime);
+    void Complete(EOnJoinSessionCompleteResult::Type InResult);
+
+    FOnlineSessionDrift& SessionInt;
+    int32 PlayerNum;
+    FName SessionName;
+    TSharedRef<FOnlineSessionSearch> SearchSettings;
+    FOnQuickJoinCompleteDelegate CompletionDelegate;
+
+    int32 NumToPing{ 0 };
+
+    EStage Stage{ EStage::Searching };
+    double StartTime{ 0.0 };
+    double StageStartTime{ 0.0 };
+
+    FDelegateHandle OnPingedHandle;
+    FDelegateHandle OnRankedHandle;
+
+    EOnJoinSessionCompleteResult::Type Result{ EOnJoinSessionCompleteResult::UnknownError };
+    FString ConnectString;
+    FDriftQuickJoinTimings Timings;
+};
@@ -0,0 +1,74 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftSearchResultBuilder.h"
+
+#include "DriftAPI.h"
+
+
+/** Upper bound on session infos per block, so a heavily filtered batch doesn't hold on to lots of unused infos */
+static const int32 MaxSessionInfoBlockSize = 256;
+
+
+FDriftSearchResultBuilder::FDriftSearchResultBuilder(TArray<FOnlineSessionSearchResult>& InResults, int32 ExpectedCount)
+: Results(InResults)
+, BlockSize(FMath::Clamp(ExpectedCount, 1, MaxSessionInfoBlockSize))
+, NextInBlock(0)
+{
+}
+
+FOnlineSessionSearchResult& FDriftSearchResultBuilder::Add(const FActiveMatch& Match)
+{
+    auto NewResult = new (Results) FOnlineSessionSearchResult{};
+    auto& NewSession = NewResult->Session;
+    NewSession.SessionSettings = GetSettingsTemplate();
+
+    auto DriftSessionInfo = AllocateSessionInfo();
+    DriftSessionInfo->SetUrl(Match.ue4_connection_url);
+    DriftSessionInfo->SetMatchId(Match.match_id);
+    // Shares the reference count of the block, which lives until its last result is gone
+    NewSession.SessionInfo = TSharedPtr<FOnlineSessionInfo>(Block, DriftSessionInfo);
+
+    UpdateSlots(NewSession, Match);
+    return *NewResult;
+}
+
+void FDriftSearchResultBuilder::UpdateSlots(FOnlineSession& Session, const FActiveMatch& Match)
+{
+    const int32 MaxPlayers = FMath::Max(Match.max_players, 0);
+    Session.SessionSettings.NumPublicConnections = MaxPlayers;
+    Session.NumOpenPublicConnections = FMath::Clamp(MaxPlayers - Match.num_players, 0, MaxPlayers);
+}
+
+FOnlineSessionInfoDrift* FDriftSearchResultBuilder::AllocateSessionInfo()
+{
+    if (!Block.IsValid() || NextInBlock >= BlockSize)
+    {
+        Block = MakeShareable(new FSessionInfoBlock{ BlockSize });
+        NextInBlock = 0;
+    }
+    return &Block->Infos[NextInBlock++];
+}
+
+const FOnlineSessionSettings& FDriftSearchResultBuilder::GetSettingsTemplate()
+{
+    static const FOnlineSessionSettings SettingsTemplate = []()
+    {
+        FOnlineSessionSettings SessionSettings;
+        SessionSettings.bAllowInvites = false;
+        SessionSettings.bAllowJoinInProgress = false;
+        SessionSettings.bAllowJoinViaPresence = false;
+        SessionSettings.bAllowJoinViaPresenceFriendsOnly = false;
+        SessionSettings.bAntiCheatProtected = false;
+        SessionSettings.bIsDedicated = true;
+        SessionSettings.bIsLANMatch = false;
+        SessionSettings.bShouldAdvertise = false;
+        SessionSettings.BuildUniqueId = 0;
+        SessionSettings.bUsesPresence = false;
+        SessionSettings.bUsesStats = false;
+        SessionSettings.NumPrivateConnections = 0;
+        SessionSettings.NumPublicConnections = 0;
+        return SessionSettings;
+    }();
+    return SettingsTemplate;
+}
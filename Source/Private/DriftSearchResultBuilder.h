@@ -0,0 +1,59 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineSessionSettings.h"
+#include "OnlineSubsystemDriftTypes.h"
+
+struct FActiveMatch;
+
+
+/**
+ * Appends search results for Drift matches in bulk
+ *
+ * Session infos are carved out of blocks allocated once per batch instead of one
+ * heap allocation and one shared reference controller per result, every result
+ * holds a reference to its block, and session settings are copied from a single
+ * prebuilt template.
+ */
+class FDriftSearchResultBuilder
+{
+public:
+    /**
+     * The array isn't reserved here, a builder can be one of many filling it, the caller reserves once for all of them
+     *
+     * @param InResults the array to append to
+     * @param ExpectedCount how many results are about to be added, used to size the first block
+     */
+    FDriftSearchResultBuilder(TArray<FOnlineSessionSearchResult>& InResults, int32 ExpectedCount);
+
+    /** Append a result for the match */
+    FOnlineSessionSearchResult& Add(const FActiveMatch& Match);
+
+    /**
+     * Fill in the player limit and open slots of a session from the match it was built from
+     * Matches that don't report a player limit get 0 for both, which means unknown, not full
+     */
+    static void UpdateSlots(FOnlineSession& Session, const FActiveMatch& Match);
+
+    /** Settings every Drift search result starts out with */
+    static const FOnlineSessionSettings& GetSettingsTemplate();
+
+private:
+    struct FSessionInfoBlock
+    {
+        explicit FSessionInfoBlock(int32 Count)
+        {
+            Infos.AddDefaulted(Count);
+        }
+
+        TArray<FOnlineSessionInfoDrift> Infos;
+    };
+
+    FOnlineSessionInfoDrift* AllocateSessionInfo();
+
+    TArray<FOnlineSessionSearchResult>& Results;
+    TSharedPtr<FSessionInfoBlock> Block;
+    int32 BlockSize;
+    int32 NextInBlock;
+};
@@ -0,0 +1,110 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftSearchResultRanker.h"
+#include "DriftMatchIndex.h"
+#include "OnlineSubsystemDriftTypes.h"
+#include "OnlineSessionInterfaceDrift.h"
+
+
+FDriftRankingWeights::FDriftRankingWeights()
+{
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("RankingWeightPing"), Ping, GEngineIni);
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("RankingWeightFill"), Fill, GEngineIni);
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("RankingWeightRegion"), Region, GEngineIni);
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("RankingWeightSkill"), Skill, GEngineIni);
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("RankingMaxPing"), MaxPing, GEngineIni);
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("RankingSkillRange"), SkillRange, GEngineIni);
+    MaxPing = FMath::Max(MaxPing, 1.0f);
+    SkillRange = FMath::Max(SkillRange, KINDA_SMALL_NUMBER);
+}
+
+
+FDriftSearchResultRanker::FDriftSearchResultRanker(const FOnlineSessionSearch& Search, const FDriftMatchIndex& Matches)
+: AnsweredBonus(FMath::Abs(Weights.Ping) + FMath::Abs(Weights.Fill) + FMath::Abs(Weights.Region) + FMath::Abs(Weights.Skill) + 1.0f)
+{
+    FString PreferredRegion;
+    if (!Search.QuerySettings.Get(SEARCH_RANK_REGION, PreferredRegion))
+    {
+        Search.QuerySettings.Get(SETTING_REGION, PreferredRegion);
+    }
+    bHasSkill = Search.QuerySettings.Get(SETTING_DRIFT_SKILL, Skill);
+
+    Candidates.Reserve(Search.SearchResults.Num());
+    for (const auto& Result : Search.SearchResults)
+    {
+        const auto& Settings = Result.Session.SessionSettings;
+        const auto SessionInfo = static_cast<const FOnlineSessionInfoDrift*>(Result.Session.SessionInfo.Get());
+        const FActiveMatch* Match = SessionInfo ? Matches.Find(static_cast<int32>(SessionInfo->GetData().MatchId)) : nullptr;
+
+        FCandidate Candidate;
+        Candidate.PingInMs = Result.PingInMs;
+        Candidate.NumPlayers = Match ? Match->num_players : 0;
+        Candidate.MaxPlayers = Match ? Match->max_players : 0;
+        Candidate.RegionMatch = PreferredRegion.IsEmpty() || Match == nullptr ? -1 : Match->placement == PreferredRegion ? 1 : 0;
+        Candidate.Skill = 0.0f;
+        Candidate.bHasSkill = Settings.Get(SETTING_DRIFT_SKILL, Candidate.Skill);
+        Candidates.Add(Candidate);
+    }
+}
+
+TArray<int32> FDriftSearchResultRanker::SelectTopK(int32 K) const
+{
+    K = FMath::Clamp(K, 0, Candidates.Num());
+
+    typedef TPair<float, int32> FScored;
+    // Worse first, so the heap top is the one to evict, equal scores keep their original order
+    auto IsWorse = [](const FScored& A, const FScored& B)
+    {
+        return A.Key < B.Key || (A.Key == B.Key && A.Value > B.Value);
+    };
+
+    TArray<FScored> Heap;
+    Heap.Reserve(K + 1);
+    for (int32 Index = 0; Index < Candidates.Num() && K > 0; ++Index)
+    {
+        const FScored Scored{ Score(Candidates[Index]), Index };
+        if (Heap.Num() < K)
+        {
+            Heap.HeapPush(Scored, IsWorse);
+        }
+        else if (IsWorse(Heap.HeapTop(), Scored))
+        {
+            Heap.HeapPopDiscard(IsWorse, false);
+            Heap.HeapPush(Scored, IsWorse);
+        }
+    }
+
+    TArray<int32> Order;
+    Order.SetNumUninitialized(Heap.Num());
+    for (int32 Slot = Heap.Num() - 1; Slot >= 0; --Slot)
+    {
+        FScored Worst;
+        Heap.HeapPop(Worst, IsWorse, false);
+        Order[Slot] = Worst.Value;
+    }
+    return Order;
+}
+
+float FDriftSearchResultRanker::Score(const FCandidate& Candidate) const
+{
+    float Total = 0.0f;
+
+    // Results that were never pinged, or didn't answer, are at MAX_QUERY_PING
+    if (Candidate.PingInMs < MAX_QUERY_PING)
+    {
+        Total += AnsweredBonus;
+    }
+    Total += Weights.Ping * (1.0f - FMath::Clamp(Candidate.PingInMs / Weights.MaxPing, 0.0f, 1.0f));
+
+    // Fuller matches start sooner, full ones are filtered out before they get here
+    const float FillScore = Candidate.MaxPlayers > 0 ? FMath::Clamp(float(Candidate.NumPlayers) / Candidate.MaxPlayers, 0.0f, 1.0f) : 0.5f;
+    Total += Weights.Fill * FillScore;
+
+    Total += Weights.Region * (Candidate.RegionMatch < 0 ? 0.5f : Candidate.RegionMatch);
+
+    const float SkillScore = bHasSkill && Candidate.bHasSkill ? 1.0f - FMath::Clamp(FMath::Abs(Candidate.Skill - Skill) / Weights.SkillRange, 0.0f, 1.0f) : 0.5f;
+    Total += Weights.Skill * SkillScore;
+
+    return Total;
+}
@@ -0,0 +1,76 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineSessionSettings.h"
+
+class FDriftMatchIndex;
+
+
+/**
+ * How much each property of a search result counts when ranking
+ *
+ * Every property is scored between 0 and 1, unknown ones in the middle, and the weighted sum decides.
+ * Results whose server answered a ping always rank ahead of those that didn't, or weren't pinged.
+ * Read from the [OnlineSubsystemDrift] ini section: RankingWeightPing, RankingWeightFill, RankingWeightRegion
+ * and RankingWeightSkill, plus RankingMaxPing (ms) and RankingSkillRange, the ping and skill difference that score 0.
+ * There is no build weight, Drift's match list doesn't say which build a server runs.
+ */
+struct FDriftRankingWeights
+{
+    float Ping{ 1.0f };
+    float Fill{ 0.5f };
+    float Region{ 0.5f };
+    float Skill{ 0.0f };
+
+    float MaxPing{ 300.0f };
+    float SkillRange{ 1000.0f };
+
+    FDriftRankingWeights();
+};
+
+
+/**
+ * Picks the best K results of a session search
+ *
+ * Everything needed is copied out of the search when the ranker is created, on the game thread, so SelectTopK()
+ * can run on any thread while the game goes on using the search. Selection keeps a K sized heap instead of
+ * sorting every result.
+ */
+class FDriftSearchResultRanker
+{
+public:
+    /**
+     * @param Search the search to rank the results of
+     * @param Matches recently seen matches, for what the search results don't carry
+     */
+    FDriftSearchResultRanker(const FOnlineSessionSearch& Search, const FDriftMatchIndex& Matches);
+
+    /** @return indices of the best K results, best first */
+    TArray<int32> SelectTopK(int32 K) const;
+
+    int32 Num() const { return Candidates.Num(); }
+
+private:
+    struct FCandidate
+    {
+        int32 PingInMs;
+        /** Players and player limit, 0 if the match isn't known */
+        int32 NumPlayers;
+        int32 MaxPlayers;
+        /** -1 unknown, 0 elsewhere, 1 in the preferred region */
+        int8 RegionMatch;
+        bool bHasSkill;
+        float Skill;
+    };
+
+    float Score(const FCandidate& Candidate) const;
+
+    FDriftRankingWeights Weights;
+    /** More than all weighted properties together, added for answered pings */
+    float AnsweredBonus{ 0.0f };
+    bool bHasSkill{ false };
+    float Skill{ 0.0f };
+
+    TArray<FCandidate> Candidates;
+};
@@ -0,0 +1,105 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftServerHeartbeat.h"
+#include "OnlineSubsystemDrift.h"
+#include "OnlineSessionDrift.h"
+
+#include "DriftAPI.h"
+
+
+FString FDriftServerHeartbeatPayload::ToString() const
+{
+    return FString::Printf(TEXT("%s players=%d open=%d frame_ms=%.1f/%.1f"),
+        EOnlineSessionState::ToString(SessionState), NumPlayers, NumOpenSlots, AverageFrameTime, MaxFrameTime);
+}
+
+
+FDriftServerHeartbeat::FDriftServerHeartbeat(FOnlineSubsystemDrift* InSubsystem)
+: DriftSubsystem(InSubsystem)
+, InFlightHeartbeat(MakeShareable(new int32(0)))
+{
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("HeartbeatIntervalIdle"), IdleInterval, GEngineIni);
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("HeartbeatIntervalInProgress"), InProgressInterval, GEngineIni);
+    GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("HeartbeatTimeout"), Timeout, GEngineIni);
+}
+
+void FDriftServerHeartbeat::Tick(float DeltaTime)
+{
+    ++NumFrames;
+    TotalFrameTime += DeltaTime;
+    MaxFrameTime = FMath::Max(MaxFrameTime, DeltaTime);
+    TimeSinceHeartbeat += DeltaTime;
+
+    if (*InFlightHeartbeat != 0)
+    {
+        if (FPlatformTime::Seconds() - HeartbeatSentTime < Timeout)
+        {
+            return;
+        }
+        // A late answer to it is ignored
+        UE_LOG_ONLINE(Warning, TEXT("No answer to server heartbeat %d after %.1f seconds"), *InFlightHeartbeat, Timeout);
+        *InFlightHeartbeat = 0;
+    }
+
+    const auto SessionState = DriftSubsystem->GetSessionInterface()->GetSessionState(GameSessionName);
+    const float Interval = SessionState == EOnlineSessionState::InProgress ? InProgressInterval : IdleInterval;
+    if (SessionState != LastSessionState || TimeSinceHeartbeat >= Interval)
+    {
+        LastSessionState = SessionState;
+        SendHeartbeat();
+    }
+}
+
+FDriftServerHeartbeatPayload FDriftServerHeartbeat::BuildPayload() const
+{
+    FDriftServerHeartbeatPayload Payload;
+    if (auto Session = DriftSubsystem->GetSessionInterface()->GetNamedSession(GameSessionName))
+    {
+        Payload.SessionState = Session->SessionState;
+        Payload.NumPlayers = Session->RegisteredPlayers.Num();
+        Payload.NumOpenSlots = Session->NumOpenPublicConnections + Session->NumOpenPrivateConnections;
+    }
+    if (NumFrames > 0)
+    {
+        Payload.AverageFrameTime = TotalFrameTime * 1000.0f / NumFrames;
+        Payload.MaxFrameTime = MaxFrameTime * 1000.0f;
+    }
+    return Payload;
+}
+
+void FDriftServerHeartbeat::SendHeartbeat()
+{
+    auto Drift = DriftSubsystem->GetDrift();
+    auto SessionInt = StaticCastSharedPtr<FOnlineSessionDrift>(DriftSubsystem->GetSessionInterface());
+    if (Drift == nullptr || SessionInt->ReportedServerStatus.IsNone())
+    {
+        // Nothing to repeat yet, try again next interval
+        TimeSinceHeartbeat = 0.0f;
+        return;
+    }
+
+    const auto Payload = BuildPayload();
+    UE_LOG_ONLINE(Verbose, TEXT("Server heartbeat: %s"), *Payload.ToString());
+
+    TimeSinceHeartbeat = 0.0f;
+    NumFrames = 0;
+    TotalFrameTime = 0.0f;
+    MaxFrameTime = 0.0f;
+
+    const int32 Heartbeat = ++LastHeartbeat;
+    *InFlightHeartbeat = Heartbeat;
+    HeartbeatSentTime = FPlatformTime::Seconds();
+    auto InFlight = InFlightHeartbeat;
+    Drift->UpdateServer(SessionInt->ReportedServerStatus.ToString(), Payload.ToString(), FDriftServerStatusUpdatedDelegate::CreateLambda([InFlight, Heartbeat](bool success)
+    {
+        if (*InFlight == Heartbeat)
+        {
+            *InFlight = 0;
+        }
+        if (!success)
+        {
+            UE_LOG_ONLINE(Warning, TEXT("Failed to send server heartbeat"));
+        }
+    }));
+}
@@ -0,0 +1,69 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineSubsystemTypes.h"
+
+class FOnlineSubsystemDrift;
+
+
+/**
+ * What a dedicated server reports about itself on every heartbeat
+ */
+struct FDriftServerHeartbeatPayload
+{
+    EOnlineSessionState::Type SessionState{ EOnlineSessionState::NoSession };
+    int32 NumPlayers{ 0 };
+    int32 NumOpenSlots{ 0 };
+
+    /** Frame times since the previous heartbeat, in milliseconds */
+    float AverageFrameTime{ 0.0f };
+    float MaxFrameTime{ 0.0f };
+
+    /** Compact single line form, e.g. "InProgress players=8 open=2 frame_ms=16.7/33.4" */
+    FString ToString() const;
+};
+
+
+/**
+ * Periodic status report from a dedicated server to Drift
+ *
+ * Sends one compact payload at a time, more often while a match is in progress
+ * (HeartbeatIntervalInProgress) than between matches (HeartbeatIntervalIdle), from the
+ * [OnlineSubsystemDrift] ini section, and right away when the game session changes state.
+ * Heartbeats only start once the session interface has had a server status acknowledged,
+ * which they repeat, with the payload as the reason. A heartbeat Drift hasn't answered within
+ * HeartbeatTimeout seconds is given up on, so a lost callback can't stop them for good.
+ */
+class FDriftServerHeartbeat
+{
+public:
+    FDriftServerHeartbeat(FOnlineSubsystemDrift* InSubsystem);
+
+    void Tick(float DeltaTime);
+
+    /** Gather the current payload, frame times are those recorded since the last heartbeat */
+    FDriftServerHeartbeatPayload BuildPayload() const;
+
+private:
+    void SendHeartbeat();
+
+    FOnlineSubsystemDrift* DriftSubsystem;
+
+    float IdleInterval{ 30.0f };
+    float InProgressInterval{ 10.0f };
+    float Timeout{ 30.0f };
+
+    float TimeSinceHeartbeat{ 0.0f };
+    EOnlineSessionState::Type LastSessionState{ EOnlineSessionState::NoSession };
+
+    int32 NumFrames{ 0 };
+    float TotalFrameTime{ 0.0f };
+    float MaxFrameTime{ 0.0f };
+
+    /** Number of the heartbeat waiting for an answer, or 0, shared with the Drift callback, which may outlive us */
+    TSharedRef<int32, ESPMode::ThreadSafe> InFlightHeartbeat;
+    int32 LastHeartbeat{ 0 };
+    /** FPlatformTime::Seconds() when the heartbeat in flight was sent */
+    double HeartbeatSentTime{ 0.0 };
+};
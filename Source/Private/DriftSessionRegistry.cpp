@@ -0,0 +1,271 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftSessionRegistry.h"
+
+
+int32 FDriftRegisteredPlayerIndex::Find(const FNamedOnlineSession& Session, const FUniqueNetId& PlayerId)
+{
+    FScopeLock ScopeLock(&Lock);
+    SyncWith(Session);
+
+    const DriftID Id = ToDriftId(PlayerId);
+    if (Id == 0)
+    {
+        FUniqueNetIdMatcher PlayerMatch(PlayerId);
+        return Session.RegisteredPlayers.IndexOfByPredicate(PlayerMatch);
+    }
+
+    const int32* Position = Positions.Find(Id);
+    if (Position == nullptr)
+    {
+        return INDEX_NONE;
+    }
+    if (!Session.RegisteredPlayers.IsValidIndex(*Position) || *Session.RegisteredPlayers[*Position] != PlayerId)
+    {
+        // Reordered behind our back
+        Rebuild(Session);
+        Position = Positions.Find(Id);
+        return Position ? *Position : INDEX_NONE;
+    }
+    return *Position;
+}
+
+void FDriftRegisteredPlayerIndex::Add(FNamedOnlineSession& Session, const TSharedRef<const FUniqueNetId>& PlayerId)
+{
+    FScopeLock ScopeLock(&Lock);
+    SyncWith(Session);
+
+    const int32 Position = Session.RegisteredPlayers.Add(PlayerId);
+    const DriftID Id = ToDriftId(*PlayerId);
+    if (Id != 0)
+    {
+        Positions.Add(Id, Position);
+    }
+    else
+    {
+        ++NumUnindexed;
+    }
+}
+
+void FDriftRegisteredPlayerIndex::RemoveAt(FNamedOnlineSession& Session, int32 PlayerIndex)
+{
+    FScopeLock ScopeLock(&Lock);
+    auto& Players = Session.RegisteredPlayers;
+    const DriftID Id = ToDriftId(*Players[PlayerIndex]);
+    if (Id != 0)
+    {
+        Positions.Remove(Id);
+    }
+    else
+    {
+        --NumUnindexed;
+    }
+
+    Players.RemoveAtSwap(PlayerIndex);
+    if (PlayerIndex < Players.Num())
+    {
+        // The last player moved into the hole
+        const DriftID MovedId = ToDriftId(*Players[PlayerIndex]);
+        if (MovedId != 0)
+        {
+            Positions.Add(MovedId, PlayerIndex);
+        }
+    }
+}
+
+DriftID FDriftRegisteredPlayerIndex::ToDriftId(const FUniqueNetId& PlayerId)
+{
+    return PlayerId.GetSize() == sizeof(DriftID) ? FUniqueNetIdDrift{ PlayerId }.GetId() : 0;
+}
+
+void FDriftRegisteredPlayerIndex::SyncWith(const FNamedOnlineSession& Session)
+{
+    if (Positions.Num() + NumUnindexed != Session.RegisteredPlayers.Num())
+    {
+        Rebuild(Session);
+    }
+}
+
+void FDriftRegisteredPlayerIndex::Rebuild(const FNamedOnlineSession& Session)
+{
+    Positions.Reset();
+    NumUnindexed = 0;
+    for (int32 Position = 0; Position < Session.RegisteredPlayers.Num(); ++Position)
+    {
+        const DriftID Id = ToDriftId(*Session.RegisteredPlayers[Position]);
+        if (Id != 0)
+        {
+            Positions.Add(Id, Position);
+        }
+        else
+        {
+            ++NumUnindexed;
+        }
+    }
+}
+
+
+EOnlineSessionState::Type FDriftSessionSnapshot::GetState(FName SessionName) const
+{
+    for (int32 Index = 0; Index < NumSessions; ++Index)
+    {
+        if (Names[Index] == SessionName)
+        {
+            return States[Index];
+        }
+    }
+    return EOnlineSessionState::NoSession;
+}
+
+
+FNamedOnlineSession* FDriftSessionRegistry::Add(FName SessionName, const FOnlineSessionSettings& SessionSettings)
+{
+    return Insert(SessionName, TUniquePtr<FEntry>(new FEntry(SessionName, SessionSettings)));
+}
+
+FNamedOnlineSession* FDriftSessionRegistry::Add(FName SessionName, const FOnlineSession& Session)
+{
+    return Insert(SessionName, TUniquePtr<FEntry>(new FEntry(SessionName, Session)));
+}
+
+FNamedOnlineSession* FDriftSessionRegistry::Insert(FName SessionName, TUniquePtr<FEntry>&& NewEntry)
+{
+    // Construct outside the lock, only the map insertion needs to be exclusive
+    FNamedOnlineSession* Result = &NewEntry->Session;
+
+    {
+        FDriftWriteScopeLock ScopeLock(Lock);
+        if (!Sessions.Contains(SessionName))
+        {
+            Sessions.Add(SessionName, MoveTemp(NewEntry));
+            PublishSnapshot();
+            return Result;
+        }
+    }
+
+    // Replacing the session would pull it out from under whoever holds a pointer to it
+    UE_LOG_ONLINE(Warning, TEXT("Not adding session '%s', a session with that name already exists"), *SessionName.ToString());
+    // NewEntry is destroyed by the caller, outside the lock
+    return nullptr;
+}
+
+FNamedOnlineSession* FDriftSessionRegistry::Find(FName SessionName) const
+{
+    FDriftReadScopeLock ScopeLock(Lock);
+    const auto Entry = Sessions.Find(SessionName);
+    return Entry ? &(*Entry)->Session : nullptr;
+}
+
+FNamedOnlineSession* FDriftSessionRegistry::Find(FName SessionName, FDriftRegisteredPlayerIndex*& OutPlayerIndex) const
+{
+    FDriftReadScopeLock ScopeLock(Lock);
+    const auto Entry = Sessions.Find(SessionName);
+    OutPlayerIndex = Entry ? &(*Entry)->PlayerIndex : nullptr;
+    return Entry ? &(*Entry)->Session : nullptr;
+}
+
+bool FDriftSessionRegistry::Remove(FName SessionName)
+{
+    TUniquePtr<FEntry> Removed;
+    {
+        FDriftWriteScopeLock ScopeLock(Lock);
+        auto Existing = Sessions.Find(SessionName);
+        if (Existing == nullptr)
+        {
+            return false;
+        }
+        Removed = MoveTemp(*Existing);
+        Sessions.Remove(SessionName);
+        PublishSnapshot();
+    }
+    // Removed is destroyed here, outside the lock
+    return true;
+}
+
+void FDriftSessionRegistry::SetState(FNamedOnlineSession& Session, EOnlineSessionState::Type State)
+{
+    // Exclusive, so the publish doesn't race another writer
+    FDriftWriteScopeLock ScopeLock(Lock);
+    Session.SessionState = State;
+    PublishSnapshot();
+}
+
+EOnlineSessionState::Type FDriftSessionRegistry::GetState(FName SessionName) const
+{
+    const auto Current = ReadSnapshot();
+    if (!Current.bOverflowed)
+    {
+        return Current.GetState(SessionName);
+    }
+
+    FDriftReadScopeLock ScopeLock(Lock);
+    const auto Entry = Sessions.Find(SessionName);
+    return Entry ? (*Entry)->Session.SessionState : EOnlineSessionState::NoSession;
+}
+
+bool FDriftSessionRegistry::HasPresenceSession() const
+{
+    FDriftReadScopeLock ScopeLock(Lock);
+    for (const auto& Entry : Sessions)
+    {
+        if (Entry.Value->Session.SessionSettings.bUsesPresence)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int32 FDriftSessionRegistry::Num() const
+{
+    const auto Current = ReadSnapshot();
+    if (!Current.bOverflowed)
+    {
+        return Current.NumSessions;
+    }
+
+    FDriftReadScopeLock ScopeLock(Lock);
+    return Sessions.Num();
+}
+
+void FDriftSessionRegistry::PublishSnapshot()
+{
+    // Build aside, so the window readers have to retry in is just the copy
+    FDriftSessionSnapshot Next;
+    for (const auto& Entry : Sessions)
+    {
+        if (Next.NumSessions == FDriftSessionSnapshot::MaxSessions)
+        {
+            Next.bOverflowed = true;
+            break;
+        }
+        Next.Names[Next.NumSessions] = Entry.Key;
+        Next.States[Next.NumSessions] = Entry.Value->Session.SessionState;
+        ++Next.NumSessions;
+    }
+
+    FPlatformAtomics::InterlockedIncrement(&SnapshotSequence);
+    Snapshot = Next;
+    FPlatformAtomics::InterlockedIncrement(&SnapshotSequence);
+}
+
+FDriftSessionSnapshot FDriftSessionRegistry::ReadSnapshot() const
+{
+    FDriftSessionSnapshot Current;
+    for (;;)
+    {
+        const int32 Sequence = SnapshotSequence;
+        if ((Sequence & 1) == 0)
+        {
+            FPlatformMisc::MemoryBarrier();
+            Current = Snapshot;
+            FPlatformMisc::MemoryBarrier();
+            if (SnapshotSequence == Sequence)
+            {
+                return Current;
+            }
+        }
+        FPlatformProcess::Yield();
+    }
+}
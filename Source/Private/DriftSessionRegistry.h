@@ -0,0 +1,203 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineSessionSettings.h"
+#include "OnlineSubsystemDriftTypes.h"
+
+
+/**
+ * Scoped shared (read) ownership of an FRWLock
+ */
+class FDriftReadScopeLock
+{
+public:
+    explicit FDriftReadScopeLock(FRWLock& InLock)
+    : Lock(InLock)
+    {
+        Lock.ReadLock();
+    }
+
+    ~FDriftReadScopeLock()
+    {
+        Lock.ReadUnlock();
+    }
+
+private:
+    FDriftReadScopeLock(const FDriftReadScopeLock&) = delete;
+    FDriftReadScopeLock& operator=(const FDriftReadScopeLock&) = delete;
+
+    FRWLock& Lock;
+};
+
+
+/**
+ * Scoped exclusive (write) ownership of an FRWLock
+ */
+class FDriftWriteScopeLock
+{
+public:
+    explicit FDriftWriteScopeLock(FRWLock& InLock)
+    : Lock(InLock)
+    {
+        Lock.WriteLock();
+    }
+
+    ~FDriftWriteScopeLock()
+    {
+        Lock.WriteUnlock();
+    }
+
+private:
+    FDriftWriteScopeLock(const FDriftWriteScopeLock&) = delete;
+    FDriftWriteScopeLock& operator=(const FDriftWriteScopeLock&) = delete;
+
+    FRWLock& Lock;
+};
+
+
+/**
+ * Hash index over FNamedOnlineSession::RegisteredPlayers, keyed by DriftID
+ *
+ * Maps every registered Drift player to its position in RegisteredPlayers, so membership tests
+ * and removals don't have to scan the array. Ids from other subsystems aren't indexed and fall
+ * back to a scan. If RegisteredPlayers is changed behind the index's back, it is rebuilt on next use.
+ * Lookups can rebuild the map, so every call takes the index's own lock; it doesn't rely on the registry's.
+ */
+class FDriftRegisteredPlayerIndex
+{
+public:
+    /** @return the position of the player in Session.RegisteredPlayers, or INDEX_NONE */
+    int32 Find(const FNamedOnlineSession& Session, const FUniqueNetId& PlayerId);
+
+    /** Append the player to Session.RegisteredPlayers */
+    void Add(FNamedOnlineSession& Session, const TSharedRef<const FUniqueNetId>& PlayerId);
+
+    /** Swap-remove the player at PlayerIndex from Session.RegisteredPlayers */
+    void RemoveAt(FNamedOnlineSession& Session, int32 PlayerIndex);
+
+private:
+    static DriftID ToDriftId(const FUniqueNetId& PlayerId);
+
+    /** Rebuild if the index doesn't account for every registered player */
+    void SyncWith(const FNamedOnlineSession& Session);
+    void Rebuild(const FNamedOnlineSession& Session);
+
+    FCriticalSection Lock;
+    TMap<DriftID, int32> Positions;
+    int32 NumUnindexed{ 0 };
+};
+
+
+/**
+ * Immutable view of the session names and states, published by FDriftSessionRegistry on every change
+ */
+struct FDriftSessionSnapshot
+{
+    /** Games have one or two sessions, more than this and readers fall back to the lock */
+    static const int32 MaxSessions = 8;
+
+    int32 NumSessions{ 0 };
+    bool bOverflowed{ false };
+    FName Names[MaxSessions];
+    EOnlineSessionState::Type States[MaxSessions];
+
+    /** @return the state of the named session, or NoSession if there is none */
+    EOnlineSessionState::Type GetState(FName SessionName) const;
+};
+
+
+/**
+ * Named session storage keyed by session name
+ *
+ * Every session lives in its own heap node, so the FNamedOnlineSession* handed out
+ * by Add() and Find() stays valid until that particular session is removed, no matter
+ * how many other sessions are added or removed in the meantime.
+ * Lookups take a shared lock and never block each other, only Add() and Remove() are exclusive.
+ *
+ * GetState() and Num() don't lock at all, they read a snapshot that is republished whenever a session
+ * is added, removed or changes state through SetState(). The snapshot is guarded by a sequence counter,
+ * so a reader that overlaps a publish simply reads again. State written to a session directly is only
+ * seen by those readers after the next publish.
+ */
+class FDriftSessionRegistry
+{
+public:
+    FDriftSessionRegistry() {}
+
+    /**
+     * Add a new session, unless there already is one with the same name
+     *
+     * @return the new session, owned by the registry, or nullptr if the name is taken
+     */
+    FNamedOnlineSession* Add(FName SessionName, const FOnlineSessionSettings& SessionSettings);
+    FNamedOnlineSession* Add(FName SessionName, const FOnlineSession& Session);
+
+    /** @return the named session, or nullptr if there is none */
+    FNamedOnlineSession* Find(FName SessionName) const;
+
+    /**
+     * @param OutPlayerIndex receives the registered player index of the session, which lives as long as the session
+     * @return the named session, or nullptr if there is none
+     */
+    FNamedOnlineSession* Find(FName SessionName, FDriftRegisteredPlayerIndex*& OutPlayerIndex) const;
+
+    /** @return true if a session was removed */
+    bool Remove(FName SessionName);
+
+    /** Change the state of a session owned by the registry and publish it */
+    void SetState(FNamedOnlineSession& Session, EOnlineSessionState::Type State);
+
+    /** @return the state of the named session, or NoSession if there is none */
+    EOnlineSessionState::Type GetState(FName SessionName) const;
+
+    /** @return true if any session has bUsesPresence set */
+    bool HasPresenceSession() const;
+
+    int32 Num() const;
+
+    /**
+     * Visit every session while holding the shared lock
+     * The visitor must not add or remove sessions
+     */
+    template<typename VisitorType>
+    void ForEach(VisitorType Visitor) const
+    {
+        FDriftReadScopeLock ScopeLock(Lock);
+        for (const auto& Entry : Sessions)
+        {
+            Visitor(Entry.Value->Session);
+        }
+    }
+
+private:
+    FDriftSessionRegistry(const FDriftSessionRegistry&) = delete;
+    FDriftSessionRegistry& operator=(const FDriftSessionRegistry&) = delete;
+
+    struct FEntry
+    {
+        template<typename... ArgTypes>
+        explicit FEntry(ArgTypes&&... Args)
+        : Session(Forward<ArgTypes>(Args)...)
+        {
+        }
+
+        FNamedOnlineSession Session;
+        FDriftRegisteredPlayerIndex PlayerIndex;
+    };
+
+    FNamedOnlineSession* Insert(FName SessionName, TUniquePtr<FEntry>&& NewEntry);
+
+    /** Rebuild the snapshot from Sessions, the caller holds Lock */
+    void PublishSnapshot();
+
+    /** Consistent copy of the published snapshot */
+    FDriftSessionSnapshot ReadSnapshot() const;
+
+    mutable FRWLock Lock;
+    TMap<FName, TUniquePtr<FEntry>> Sessions;
+
+    /** Odd while a publish is in progress */
+    volatile int32 SnapshotSequence{ 0 };
+    FDriftSessionSnapshot Snapshot;
+};
@@ -0,0 +1,112 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftSessionSearch.h"
+#include "DriftSearchResultBuilder.h"
+#include "OnlineSessionDrift.h"
+
+#include "DriftAPI.h"
+
+
+FDriftSessionSearch::FDriftSessionSearch(const TSharedRef<FOnlineSessionSearch>& InSearchSettings)
+: SearchSettings(InSearchSettings)
+, Query(*InSearchSettings)
+{
+    SearchSettings->QuerySettings.Get(SEARCH_STREAM_RESULTS, bStreamResults);
+}
+
+bool FDriftSessionSearch::CanShareWith(const FDriftSessionSearch& Other) const
+{
+    // Streamed results reach their listeners page by page, a copy at the end would be too late
+    return !HasMatches() && !bStreamResults && !Other.bStreamResults && Query == Other.Query;
+}
+
+bool FDriftSessionSearch::Serves(const FOnlineSessionSearch& Search) const
+{
+    return &SearchSettings.Get() == &Search || Followers.ContainsByPredicate([&Search](const TSharedRef<FOnlineSessionSearch>& Follower)
+    {
+        return &Follower.Get() == &Search;
+    });
+}
+
+void FDriftSessionSearch::SetMatches(const TSharedRef<FMatchesSearch>& InMatches, bool bInSucceeded)
+{
+    Matches = InMatches;
+    bSucceeded = bInSucceeded;
+    NextMatchIndex = 0;
+}
+
+bool FDriftSessionSearch::AddResults(int32 MaxMatchesToProcess)
+{
+    const auto& MatchList = Matches->matches;
+    auto& SearchResults = SearchSettings->SearchResults;
+    const int32 MaxResults = Query.MaxResults > 0 ? Query.MaxResults : MAX_int32;
+    const int32 EndIndex = FMath::Min(MatchList.Num(), NextMatchIndex + FMath::Min(MaxMatchesToProcess, MatchList.Num()));
+
+    if (NextMatchIndex == 0)
+    {
+        // Once per search, every page after the first fills space that's already there
+        SearchResults.Reserve(FMath::Min(MaxResults, MatchList.Num()));
+    }
+
+    FDriftSearchResultBuilder Builder{ SearchResults, FMath::Min(MaxResults - SearchResults.Num(), EndIndex - NextMatchIndex) };
+    for (; NextMatchIndex < EndIndex && SearchResults.Num() < MaxResults; ++NextMatchIndex)
+    {
+        const auto& ActiveMatch = MatchList[NextMatchIndex];
+        if (Query.Matches(ActiveMatch))
+        {
+            Builder.Add(ActiveMatch);
+        }
+    }
+
+    return NextMatchIndex >= MatchList.Num() || SearchResults.Num() >= MaxResults;
+}
+
+void FDriftSessionSearch::Complete()
+{
+    const auto State = bSucceeded ? EOnlineAsyncTaskState::Done : EOnlineAsyncTaskState::Failed;
+    SearchSettings->SearchState = State;
+    for (const auto& Follower : Followers)
+    {
+        // Session infos are shared, so this is a copy of pointers and settings
+        Follower->SearchResults = SearchSettings->SearchResults;
+        Follower->SearchState = State;
+    }
+}
+
+bool FDriftSessionSearch::Cancel(const FOnlineSessionSearch& Search)
+{
+    TSharedPtr<FOnlineSessionSearch> Cancelled;
+    if (&SearchSettings.Get() == &Search)
+    {
+        Cancelled = SearchSettings;
+        if (Followers.Num() == 0)
+        {
+            Cancelled->SearchState = EOnlineAsyncTaskState::Failed;
+            Cancelled->SearchResults.Empty();
+            return false;
+        }
+        // Followers only exist while there are no results, so there is nothing to hand over
+        SearchSettings = Followers[0];
+        Followers.RemoveAt(0);
+    }
+    else
+    {
+        const int32 Index = Followers.IndexOfByPredicate([&Search](const TSharedRef<FOnlineSessionSearch>& Follower)
+        {
+            return &Follower.Get() == &Search;
+        });
+        if (Index != INDEX_NONE)
+        {
+            Cancelled = Followers[Index];
+            Followers.RemoveAt(Index);
+        }
+    }
+
+    if (Cancelled.IsValid())
+    {
+        Cancelled->SearchState = EOnlineAsyncTaskState::Failed;
+        Cancelled->SearchResults.Empty();
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineSessionSettings.h"
+#include "DriftMatchQuery.h"
+
+struct FMatchesSearch;
+
+
+/**
+ * A FindSessions call in progress
+ *
+ * Every search waits for a match list, filters it with its own query and adds the survivors to its
+ * FOnlineSessionSearch, all at once or page by page. Searches that ask the exact same question while
+ * one is still waiting for its list don't get their own entry. They ride along as followers and get a
+ * copy of its results.
+ */
+class FDriftSessionSearch
+{
+public:
+    explicit FDriftSessionSearch(const TSharedRef<FOnlineSessionSearch>& InSearchSettings);
+
+    /** @return true if the other search would get the same results, and can follow this one */
+    bool CanShareWith(const FDriftSessionSearch& Other) const;
+
+    /** @return true if this is the search, or it follows this one */
+    bool Serves(const FOnlineSessionSearch& Search) const;
+
+    /** Hand the search the match list to build its results from */
+    void SetMatches(const TSharedRef<FMatchesSearch>& InMatches, bool bInSucceeded);
+
+    bool HasMatches() const { return Matches.IsValid(); }
+
+    /**
+     * Turn matches into results, continuing where the last call stopped
+     *
+     * @param MaxMatchesToProcess how many matches to look at, including those filtered out
+     * @return true when there is nothing left to add
+     */
+    bool AddResults(int32 MaxMatchesToProcess);
+
+    /** Copy the results to the followers and mark everyone done, or failed */
+    void Complete();
+
+    /**
+     * Stop serving a search, it is marked failed and gets no results
+     * If it's the search itself and there are followers, the first one takes over
+     *
+     * @return false if there is no one left to serve, the whole search can go
+     */
+    bool Cancel(const FOnlineSessionSearch& Search);
+
+    TSharedRef<FOnlineSessionSearch> SearchSettings;
+    FDriftMatchQuery Query;
+
+    /** Results are added page by page, see SEARCH_STREAM_RESULTS */
+    bool bStreamResults{ false };
+
+    /** The match list request succeeded */
+    bool bSucceeded{ false };
+
+    /** Searches with the same query that get a copy of the results */
+    TArray<TSharedRef<FOnlineSessionSearch>> Followers;
+
+private:
+    /** The list results come from, set once it has arrived */
+    TSharedPtr<FMatchesSearch> Matches;
+
+    /** Next entry in Matches to turn into a search result */
+    int32 NextMatchIndex{ 0 };
+};
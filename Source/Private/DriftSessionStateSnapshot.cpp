@@ -0,0 +1,55 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "DriftSessionStateSnapshot.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+
+
+FString FDriftSessionStateSnapshot::ToJson() const
+{
+    FString Json;
+    auto Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Json);
+
+    Writer->WriteObjectStart();
+    Writer->WriteValue(TEXT("time"), CaptureTime);
+
+    Writer->WriteArrayStart(TEXT("sessions"));
+    for (const auto& Session : Sessions)
+    {
+        Writer->WriteObjectStart();
+        Writer->WriteValue(TEXT("name"), Session.Name.ToString());
+        Writer->WriteValue(TEXT("state"), FString(EOnlineSessionState::ToString(Session.State)));
+        Writer->WriteValue(TEXT("session_id"), Session.SessionId);
+        Writer->WriteValue(TEXT("connect"), Session.ConnectString);
+        Writer->WriteValue(TEXT("public_slots"), Session.NumPublicConnections);
+        Writer->WriteValue(TEXT("open_public_slots"), Session.NumOpenPublicConnections);
+        Writer->WriteValue(TEXT("private_slots"), Session.NumPrivateConnections);
+        Writer->WriteValue(TEXT("open_private_slots"), Session.NumOpenPrivateConnections);
+        Writer->WriteArrayStart(TEXT("players"));
+        for (const auto& PlayerId : Session.RegisteredPlayers)
+        {
+            Writer->WriteValue(PlayerId->ToString());
+        }
+        Writer->WriteArrayEnd();
+        Writer->WriteObjectEnd();
+    }
+    Writer->WriteArrayEnd();
+
+    Writer->WriteObjectStart(TEXT("pending"));
+    Writer->WriteValue(TEXT("session_tasks"), NumPendingSessionTasks);
+    Writer->WriteValue(TEXT("player_updates"), NumQueuedPlayerUpdates);
+    Writer->WriteValue(TEXT("searches"), NumActiveSearches);
+    Writer->WriteValue(TEXT("session_lookups"), NumPendingSessionLookups);
+    Writer->WriteValue(TEXT("rankings"), NumPendingRankings);
+    Writer->WriteValue(TEXT("quick_joins"), NumQuickJoins);
+    Writer->WriteValue(TEXT("match_list"), bFetchingMatchList);
+    Writer->WriteValue(TEXT("match_queue"), bInMatchQueue);
+    Writer->WriteObjectEnd();
+
+    Writer->WriteValue(TEXT("server_status"), ReportedServerStatus.IsNone() ? FString() : ReportedServerStatus.ToString());
+    Writer->WriteObjectEnd();
+    Writer->Close();
+
+    return Json;
+}
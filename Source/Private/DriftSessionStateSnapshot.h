@@ -0,0 +1,47 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineSessionSettings.h"
+
+
+/**
+ * Copy of the session state, for machines rather than people
+ *
+ * Filled in by FOnlineSessionDrift::CaptureSessionState(), which holds the session lock only for as long as it
+ * takes to copy a few fields per session. Player ids are copied as references, they're only turned into strings
+ * by ToJson(), after the lock is gone.
+ */
+struct FDriftSessionStateSnapshot
+{
+    struct FSession
+    {
+        FName Name;
+        EOnlineSessionState::Type State{ EOnlineSessionState::NoSession };
+        FString SessionId;
+        FString ConnectString;
+        int32 NumPublicConnections{ 0 };
+        int32 NumOpenPublicConnections{ 0 };
+        int32 NumPrivateConnections{ 0 };
+        int32 NumOpenPrivateConnections{ 0 };
+        TArray<TSharedRef<const FUniqueNetId>> RegisteredPlayers;
+    };
+
+    /** FPlatformTime::Seconds() when captured */
+    double CaptureTime{ 0.0 };
+
+    TArray<FSession> Sessions;
+
+    int32 NumPendingSessionTasks{ 0 };
+    int32 NumQueuedPlayerUpdates{ 0 };
+    int32 NumActiveSearches{ 0 };
+    int32 NumPendingSessionLookups{ 0 };
+    int32 NumPendingRankings{ 0 };
+    int32 NumQuickJoins{ 0 };
+    bool bFetchingMatchList{ false };
+    bool bInMatchQueue{ false };
+    FName ReportedServerStatus;
+
+    /** Serialize as a single line of JSON */
+    FString ToJson() const;
+};
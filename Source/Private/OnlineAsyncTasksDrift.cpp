@@ -0,0 +1,587 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#include "OnlineSubsystemDriftPrivatePCH.h"
+#include "OnlineAsyncTasksDrift.h"
+#include "OnlineSubsystemDrift.h"
+#include "OnlineSessionDrift.h"
+
+
+namespace
+{
+    struct FDriftRequestConfig
+    {
+        float Timeout{ 10.0f };
+        int32 MaxAttempts{ 3 };
+        float RetryDelay{ 1.0f };
+
+        FDriftRequestConfig()
+        {
+            GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("SessionRequestTimeout"), Timeout, GEngineIni);
+            GConfig->GetInt(DRIFT_CONFIG_SECTION, TEXT("SessionRequestMaxAttempts"), MaxAttempts, GEngineIni);
+            GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("SessionRequestRetryDelay"), RetryDelay, GEngineIni);
+            MaxAttempts = FMath::Max(MaxAttempts, 1);
+        }
+    };
+
+    /** Read on first use, which is on the game thread since that's where tasks are created */
+    const FDriftRequestConfig& GetRequestConfig()
+    {
+        static const FDriftRequestConfig Config;
+        return Config;
+    }
+
+    FOnlineSessionDriftPtr GetSessionInterface(FOnlineSubsystemDrift* Subsystem)
+    {
+        return StaticCastSharedPtr<FOnlineSessionDrift>(Subsystem->GetSessionInterface());
+    }
+
+    /** @return true if the session is going away, or gone, so updating it in Drift is pointless */
+    bool IsSessionGoingAway(FOnlineSubsystemDrift* Subsystem, FName SessionName)
+    {
+        auto SessionInt = GetSessionInterface(Subsystem);
+        if (!SessionInt.IsValid())
+        {
+            return true;
+        }
+        const auto State = SessionInt->GetSessionState(SessionName);
+        return State == EOnlineSessionState::Destroying || State == EOnlineSessionState::NoSession;
+    }
+}
+
+
+/**
+ * Sends one attempt of a task's request, on the game thread
+ */
+class FOnlineAsyncItemDriftSendRequest : public FOnlineAsyncItem
+{
+public:
+    FOnlineAsyncItemDriftSendRequest(FOnlineSubsystemDrift* InSubsystem, FOnlineAsyncTaskDriftRequest* InTask, const FDriftRequestStateRef& InRequest)
+    : Subsystem(InSubsystem)
+    , Task(InTask)
+    , Request(InRequest)
+    {
+    }
+
+    virtual FString ToString() const override
+    {
+        return FString::Printf(TEXT("FOnlineAsyncItemDriftSendRequest for %s"), *Task->ToString());
+    }
+
+    virtual void Finalize() override
+    {
+        // The task is still alive, it can't complete before this item has gone through the out queue
+        if (Request->bAbandoned)
+        {
+            return;
+        }
+
+        auto Drift = Subsystem->GetDrift();
+        if (Drift == nullptr)
+        {
+            Request->Respond(false, false);
+            return;
+        }
+        Task->SendRequest(*Drift, Request);
+    }
+
+private:
+    FOnlineSubsystemDrift* Subsystem;
+    FOnlineAsyncTaskDriftRequest* Task;
+    FDriftRequestStateRef Request;
+};
+
+
+/**
+ * Undoes what an abandoned attempt hooked into Drift, on the game thread
+ * Goes through the out queue after the attempt's send item, so the send has either happened or been skipped
+ */
+class FOnlineAsyncItemDriftAbandonRequest : public FOnlineAsyncItem
+{
+public:
+    FOnlineAsyncItemDriftAbandonRequest(const FDriftRequestStateRef& InRequest)
+    : Request(InRequest)
+    {
+    }
+
+    virtual FString ToString() const override
+    {
+        return TEXT("FOnlineAsyncItemDriftAbandonRequest");
+    }
+
+    virtual void Finalize() override
+    {
+        if (Request->OnAbandoned)
+        {
+            auto OnAbandoned = MoveTemp(Request->OnAbandoned);
+            Request->OnAbandoned = nullptr;
+            OnAbandoned();
+        }
+    }
+
+private:
+    FDriftRequestStateRef Request;
+};
+
+
+FOnlineAsyncTaskDriftRequest::FOnlineAsyncTaskDriftRequest(FOnlineSubsystemDrift* InSubsystem, bool bInRetryOnTimeout)
+: FOnlineAsyncTaskBasic(InSubsystem)
+, bTimedOut(false)
+, NumAttempts(0)
+, bRetryOnTimeout(bInRetryOnTimeout)
+, Timeout(GetRequestConfig().Timeout)
+, MaxAttempts(GetRequestConfig().MaxAttempts)
+, RetryDelay(GetRequestConfig().RetryDelay)
+, AttemptTime(0.0)
+{
+    Subsystem->NumPendingSessionTasks.Increment();
+}
+
+FOnlineAsyncTaskDriftRequest::~FOnlineAsyncTaskDriftRequest()
+{
+    Subsystem->NumPendingSessionTasks.Decrement();
+}
+
+void FOnlineAsyncTaskDriftRequest::Tick()
+{
+    if (IsSuperseded())
+    {
+        UE_LOG_ONLINE(Log, TEXT("%s: superseded after %d attempts, giving up"), *ToString(), NumAttempts);
+        if (Request.IsValid())
+        {
+            Abandon();
+        }
+        Complete(false);
+        return;
+    }
+
+    if (NumAttempts == 0 && !HasRequest())
+    {
+        Complete(true);
+        return;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+
+    if (!Request.IsValid())
+    {
+        if (Now >= AttemptTime)
+        {
+            SendAttempt(Now);
+        }
+        return;
+    }
+
+    if (Request->bResponded)
+    {
+        if (Request->bSucceeded)
+        {
+            Complete(true);
+        }
+        else if (Request->bCanRetry && NumAttempts < MaxAttempts)
+        {
+            RetryLater(Now);
+        }
+        else
+        {
+            Complete(false);
+        }
+    }
+    else if (Now - AttemptTime > Timeout)
+    {
+        UE_LOG_ONLINE(Warning, TEXT("%s: no response from Drift after %.1f seconds"), *ToString(), Timeout);
+        if (bRetryOnTimeout && NumAttempts < MaxAttempts)
+        {
+            RetryLater(Now);
+        }
+        else
+        {
+            Abandon();
+            bTimedOut = true;
+            Complete(false);
+        }
+    }
+}
+
+void FOnlineAsyncTaskDriftRequest::SendAttempt(double Now)
+{
+    ++NumAttempts;
+    AttemptTime = Now;
+    Request = MakeShareable(new FDriftRequestState());
+    Subsystem->QueueAsyncOutgoingItem(new FOnlineAsyncItemDriftSendRequest(Subsystem, this, Request.ToSharedRef()));
+}
+
+void FOnlineAsyncTaskDriftRequest::RetryLater(double Now)
+{
+    Abandon();
+
+    const float Delay = RetryDelay * FMath::Pow(2.0f, static_cast<float>(NumAttempts - 1));
+    AttemptTime = Now + Delay;
+    UE_LOG_ONLINE(Log, TEXT("%s: attempt %d of %d failed, retrying in %.1f seconds"), *ToString(), NumAttempts, MaxAttempts, Delay);
+}
+
+void FOnlineAsyncTaskDriftRequest::Abandon()
+{
+    Request->bAbandoned = true;
+    Subsystem->QueueAsyncOutgoingItem(new FOnlineAsyncItemDriftAbandonRequest(Request.ToSharedRef()));
+    Request.Reset();
+}
+
+void FOnlineAsyncTaskDriftRequest::Complete(bool bSuccess)
+{
+    bWasSuccessful = bSuccess;
+    bIsComplete = true;
+}
+
+
+FOnlineAsyncTaskDriftCreateSession::FOnlineAsyncTaskDriftCreateSession(FOnlineSubsystemDrift* InSubsystem, FName InSessionName)
+: FOnlineAsyncTaskDriftRequest(InSubsystem, false)
+, SessionName(InSessionName)
+{
+}
+
+FString FOnlineAsyncTaskDriftCreateSession::ToString() const
+{
+    return FString::Printf(TEXT("FOnlineAsyncTaskDriftCreateSession bWasSuccessful: %d SessionName: %s"), bWasSuccessful, *SessionName.ToString());
+}
+
+bool FOnlineAsyncTaskDriftCreateSession::IsSuperseded() const
+{
+    return IsSessionGoingAway(Subsystem, SessionName);
+}
+
+void FOnlineAsyncTaskDriftCreateSession::SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request)
+{
+    IDriftAPI* DriftPtr = &Drift;
+    TSharedRef<FDelegateHandle, ESPMode::ThreadSafe> Handle = MakeShareable(new FDelegateHandle());
+    *Handle = Drift.OnMatchAdded().AddLambda([DriftPtr, Handle, Request](bool success)
+    {
+        DriftPtr->OnMatchAdded().Remove(*Handle);
+        Request->Respond(success);
+    });
+    Request->OnAbandoned = [DriftPtr, Handle]()
+    {
+        DriftPtr->OnMatchAdded().Remove(*Handle);
+    };
+    // TODO: Use actual settings, but backend only really works with 2 players now
+    Drift.AddMatch(TEXT(""), TEXT(""), 1, 2);
+}
+
+void FOnlineAsyncTaskDriftCreateSession::Finalize()
+{
+    auto SessionInt = GetSessionInterface(Subsystem);
+    FNamedOnlineSession* Session = SessionInt->GetNamedSession(SessionName);
+    // Destroyed while it was being created, the destroy owns it now
+    if (Session && Session->SessionState == EOnlineSessionState::Creating)
+    {
+        if (bWasSuccessful)
+        {
+            SessionInt->Sessions.SetState(*Session, EOnlineSessionState::Pending);
+        }
+        else
+        {
+            SessionInt->RemoveNamedSession(SessionName);
+        }
+    }
+}
+
+void FOnlineAsyncTaskDriftCreateSession::TriggerDelegates()
+{
+    auto SessionInt = GetSessionInterface(Subsystem);
+    if (SessionInt.IsValid())
+    {
+        SessionInt->TriggerOnCreateSessionCompleteDelegates(SessionName, bWasSuccessful);
+    }
+}
+
+
+FOnlineAsyncTaskDriftStartSession::FOnlineAsyncTaskDriftStartSession(FOnlineSubsystemDrift* InSubsystem, FName InSessionName)
+: FOnlineAsyncTaskDriftRequest(InSubsystem)
+, SessionName(InSessionName)
+{
+}
+
+FString FOnlineAsyncTaskDriftStartSession::ToString() const
+{
+    return FString::Printf(TEXT("FOnlineAsyncTaskDriftStartSession bWasSuccessful: %d SessionName: %s"), bWasSuccessful, *SessionName.ToString());
+}
+
+bool FOnlineAsyncTaskDriftStartSession::IsSuperseded() const
+{
+    return IsSessionGoingAway(Subsystem, SessionName);
+}
+
+void FOnlineAsyncTaskDriftStartSession::SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request)
+{
+    static const FName RunningStatus{ TEXT("running") };
+
+    // The server stays running between matches, only tell the backend once
+    auto SessionInt = GetSessionInterface(Subsystem);
+    const bool bUpdateServer = SessionInt->ReportedServerStatus != RunningStatus;
+    TWeakPtr<FOnlineSessionDrift, ESPMode::ThreadSafe> WeakSessionInt = SessionInt;
+
+    // All updates have to go through
+    TSharedRef<FThreadSafeCounter, ESPMode::ThreadSafe> NumPending = MakeShareable(new FThreadSafeCounter(bUpdateServer ? 2 : 1));
+    auto OnUpdated = [NumPending, Request](bool success)
+    {
+        if (!success)
+        {
+            Request->Respond(false);
+        }
+        else if (NumPending->Decrement() == 0)
+        {
+            Request->Respond(true);
+        }
+    };
+    if (bUpdateServer)
+    {
+        Drift.UpdateServer(RunningStatus.ToString(), TEXT(""), FDriftServerStatusUpdatedDelegate::CreateLambda([OnUpdated, WeakSessionInt](bool success)
+        {
+            auto PinnedSessionInt = WeakSessionInt.Pin();
+            if (success && PinnedSessionInt.IsValid())
+            {
+                PinnedSessionInt->ReportedServerStatus = RunningStatus;
+            }
+            OnUpdated(success);
+        }));
+    }
+    Drift.UpdateMatch(TEXT("started"), TEXT(""), FDriftMatchStatusUpdatedDelegate::CreateLambda(OnUpdated));
+}
+
+void FOnlineAsyncTaskDriftStartSession::Finalize()
+{
+    auto SessionInt = GetSessionInterface(Subsystem);
+    FNamedOnlineSession* Session = SessionInt->GetNamedSession(SessionName);
+    if (Session && Session->SessionState == EOnlineSessionState::Starting)
+    {
+        // The match is running whether the backend heard about it or not
+        SessionInt->Sessions.SetState(*Session, EOnlineSessionState::InProgress);
+    }
+}
+
+void FOnlineAsyncTaskDriftStartSession::TriggerDelegates()
+{
+    auto SessionInt = GetSessionInterface(Subsystem);
+    if (SessionInt.IsValid())
+    {
+        SessionInt->TriggerOnStartSessionCompleteDelegates(SessionName, bWasSuccessful);
+    }
+}
+
+
+FOnlineAsyncTaskDriftEndSession::FOnlineAsyncTaskDriftEndSession(FOnlineSubsystemDrift* InSubsystem, FName InSessionName)
+: FOnlineAsyncTaskDriftRequest(InSubsystem)
+, SessionName(InSessionName)
+{
+}
+
+FString FOnlineAsyncTaskDriftEndSession::ToString() const
+{
+    return FString::Printf(TEXT("FOnlineAsyncTaskDriftEndSession bWasSuccessful: %d SessionName: %s"), bWasSuccessful, *SessionName.ToString());
+}
+
+bool FOnlineAsyncTaskDriftEndSession::IsSuperseded() const
+{
+    return IsSessionGoingAway(Subsystem, SessionName);
+}
+
+void FOnlineAsyncTaskDriftEndSession::SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request)
+{
+    Drift.UpdateMatch(TEXT("ended"), TEXT(""), FDriftMatchStatusUpdatedDelegate::CreateLambda([Request](bool success)
+    {
+        Request->Respond(success);
+    }));
+}
+
+void FOnlineAsyncTaskDriftEndSession::Finalize()
+{
+    auto SessionInt = GetSessionInterface(Subsystem);
+    FNamedOnlineSession* Session = SessionInt->GetNamedSession(SessionName);
+    if (Session && Session->SessionState == EOnlineSessionState::Ending)
+    {
+        SessionInt->Sessions.SetState(*Session, EOnlineSessionState::Ended);
+    }
+}
+
+void FOnlineAsyncTaskDriftEndSession::TriggerDelegates()
+{
+    auto SessionInt = GetSessionInterface(Subsystem);
+    if (SessionInt.IsValid())
+    {
+        SessionInt->TriggerOnEndSessionCompleteDelegates(SessionName, bWasSuccessful);
+    }
+}
+
+
+FOnlineAsyncTaskDriftDestroySession::FOnlineAsyncTaskDriftDestroySession(FOnlineSubsystemDrift* InSubsystem, FName InSessionName, const FOnDestroySessionCompleteDelegate& InCompletionDelegate)
+: FOnlineAsyncTaskDriftRequest(InSubsystem)
+, SessionName(InSessionName)
+, CompletionDelegate(InCompletionDelegate)
+, bSessionRemoved(false)
+{
+}
+
+FString FOnlineAsyncTaskDriftDestroySession::ToString() const
+{
+    return FString::Printf(TEXT("FOnlineAsyncTaskDriftDestroySession bWasSuccessful: %d SessionName: %s"), bWasSuccessful, *SessionName.ToString());
+}
+
+void FOnlineAsyncTaskDriftDestroySession::SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request)
+{
+    Drift.UpdateMatch(TEXT("completed"), TEXT(""), FDriftMatchStatusUpdatedDelegate::CreateLambda([Request](bool success)
+    {
+        Request->Respond(success);
+    }));
+}
+
+void FOnlineAsyncTaskDriftDestroySession::Finalize()
+{
+    if (!bWasSuccessful)
+    {
+        UE_LOG_ONLINE(Warning, TEXT("Failed to mark the match of session (%s) as completed"), *SessionName.ToString());
+    }
+
+    auto SessionInt = GetSessionInterface(Subsystem);
+    if (SessionInt.IsValid() && SessionInt->GetNamedSession(SessionName))
+    {
+        SessionInt->RemoveNamedSession(SessionName);
+        bSessionRemoved = true;
+    }
+}
+
+void FOnlineAsyncTaskDriftDestroySession::TriggerDelegates()
+{
+    CompletionDelegate.ExecuteIfBound(SessionName, bSessionRemoved);
+
+    auto SessionInt = GetSessionInterface(Subsystem);
+    if (SessionInt.IsValid())
+    {
+        SessionInt->TriggerOnDestroySessionCompleteDelegates(SessionName, bSessionRemoved);
+    }
+}
+
+
+FOnlineAsyncTaskDriftJoinSession::FOnlineAsyncTaskDriftJoinSession(FOnlineSubsystemDrift* InSubsystem, FName InSessionName)
+: FOnlineAsyncTaskDriftRequest(InSubsystem)
+, SessionName(InSessionName)
+{
+}
+
+FString FOnlineAsyncTaskDriftJoinSession::ToString() const
+{
+    return FString::Printf(TEXT("FOnlineAsyncTaskDriftJoinSession bWasSuccessful: %d SessionName: %s"), bWasSuccessful, *SessionName.ToString());
+}
+
+void FOnlineAsyncTaskDriftJoinSession::Finalize()
+{
+    // We're leaving for a match, whatever got us here is done
+    if (auto Drift = Subsystem->GetDrift())
+    {
+        Drift->ResetMatchQueue();
+    }
+
+
+    auto SessionInt = GetSessionInterface(Subsystem);
+    FNamedOnlineSession* Session = SessionInt->GetNamedSession(SessionName);
+    if (Session)
+    {
+        SessionInt->Sessions.SetState(*Session, EOnlineSessionState::Pending);
+        SessionInt->RegisterLocalPlayers(Session);
+    }
+}
+
+void FOnlineAsyncTaskDriftJoinSession::TriggerDelegates()
+{
+    auto SessionInt = GetSessionInterface(Subsystem);
+    if (SessionInt.IsValid())
+    {
+        SessionInt->TriggerOnJoinSessionCompleteDelegates(SessionName, bWasSuccessful ? EOnJoinSessionCompleteResult::Success : EOnJoinSessionCompleteResult::UnknownError);
+    }
+}
+
+
+FOnlineAsyncTaskDriftJoinMatchQueue::FOnlineAsyncTaskDriftJoinMatchQueue(FOnlineSubsystemDrift* InSubsystem, FName InSessionName, EMode InMode, const FString& InArgument)
+// Sending an invite twice would invite twice
+: FOnlineAsyncTaskDriftRequest(InSubsystem, InMode != EMode::Invite)
+, SessionName(InSessionName)
+, Mode(InMode)
+, Argument(InArgument)
+, MatchQueueGeneration(GetSessionInterface(InSubsystem)->MatchQueueGeneration.GetValue())
+, Status(MakeShareable(new FMatchQueueStatus()))
+{
+}
+
+FString FOnlineAsyncTaskDriftJoinMatchQueue::ToString() const
+{
+    return FString::Printf(TEXT("FOnlineAsyncTaskDriftJoinMatchQueue bWasSuccessful: %d SessionName: %s"), bWasSuccessful, *SessionName.ToString());
+}
+
+bool FOnlineAsyncTaskDriftJoinMatchQueue::IsSuperseded() const
+{
+    auto SessionInt = GetSessionInterface(Subsystem);
+    return !SessionInt.IsValid() || SessionInt->MatchQueueGeneration.GetValue() != MatchQueueGeneration;
+}
+
+void FOnlineAsyncTaskDriftJoinMatchQueue::SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request)
+{
+    auto StatusRef = Status;
+    auto OnJoined = FDriftJoinedMatchQueueDelegate::CreateLambda([StatusRef, Request](bool success, const FMatchQueueStatus& status)
+    {
+        *StatusRef = status;
+        Request->Respond(success);
+    });
+
+    switch (Mode)
+    {
+    case EMode::Invite:
+        Drift.InvitePlayerToMatch(FUniqueNetIdDrift{ Argument }.GetId(), OnJoined);
+        break;
+    case EMode::AcceptInvite:
+    {
+        FMatchInvite invite;
+        invite.token = Argument;
+        Drift.AcceptMatchInvite(invite, OnJoined);
+        break;
+    }
+    default:
+        Drift.JoinMatchQueue(OnJoined);
+        break;
+    }
+}
+
+void FOnlineAsyncTaskDriftJoinMatchQueue::TriggerDelegates()
+{
+    auto SessionInt = GetSessionInterface(Subsystem);
+    if (SessionInt.IsValid() && !IsSuperseded())
+    {
+        SessionInt->OnJoinedMatchQueue(bWasSuccessful, *Status);
+    }
+}
+
+
+FOnlineAsyncTaskDriftLeaveMatchQueue::FOnlineAsyncTaskDriftLeaveMatchQueue(FOnlineSubsystemDrift* InSubsystem, FName InSessionName)
+: FOnlineAsyncTaskDriftRequest(InSubsystem)
+, SessionName(InSessionName)
+{
+}
+
+FString FOnlineAsyncTaskDriftLeaveMatchQueue::ToString() const
+{
+    return FString::Printf(TEXT("FOnlineAsyncTaskDriftLeaveMatchQueue bWasSuccessful: %d SessionName: %s"), bWasSuccessful, *SessionName.ToString());
+}
+
+void FOnlineAsyncTaskDriftLeaveMatchQueue::SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request)
+{
+    Drift.LeaveMatchQueue(FDriftLeftMatchQueueDelegate::CreateLambda([Request](bool success)
+    {
+        Request->Respond(success);
+    }));
+}
+
+void FOnlineAsyncTaskDriftLeaveMatchQueue::TriggerDelegates()
+{
+    auto SessionInt = GetSessionInterface(Subsystem);
+    if (SessionInt.IsValid())
+    {
+        SessionInt->OnLeftMatchQueue(SessionName, bWasSuccessful);
+    }
+}
@@ -0,0 +1,286 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineAsyncTaskManager.h"
+#include "OnlineSessionInterface.h"
+#include "OnlineSubsystemDriftTypes.h"
+
+#include "DriftAPI.h"
+
+class FOnlineSubsystemDrift;
+
+
+/**
+ * Outcome of a single Drift request, shared between the task waiting for it and the Drift callback
+ *
+ * Written on the game thread when Drift responds, read on the online thread by the task.
+ * A task that gave up on a request abandons it, so a late response, or a send that hasn't
+ * happened yet, is ignored.
+ */
+struct FDriftRequestState
+{
+    FThreadSafeBool bResponded;
+    FThreadSafeBool bSucceeded;
+    FThreadSafeBool bCanRetry;
+    FThreadSafeBool bAbandoned;
+
+    /** Set by SendRequest to undo what it hooked into Drift, run on the game thread if the request is abandoned */
+    TFunction<void()> OnAbandoned;
+
+    FDriftRequestState()
+    : bCanRetry(true)
+    {
+    }
+
+    /**
+     * Record the response, only the first one counts
+     *
+     * @param bSuccess whether the request did what it was asked to
+     * @param bInCanRetry false if sending the request again can't help
+     */
+    void Respond(bool bSuccess, bool bInCanRetry = true)
+    {
+        if (!bResponded)
+        {
+            bSucceeded = bSuccess;
+            bCanRetry = bInCanRetry;
+            bResponded = true;
+        }
+    }
+};
+
+typedef TSharedRef<FDriftRequestState, ESPMode::ThreadSafe> FDriftRequestStateRef;
+
+
+/**
+ * Base for session tasks that wait on the Drift backend
+ *
+ * The Drift API may only be used from the game thread, so every attempt is marshaled there through
+ * the async task manager's out queue, sent, and then waited on from the online thread without holding
+ * up the game. Attempts that fail or time out are retried with exponential backoff, using
+ * SessionRequestTimeout, SessionRequestMaxAttempts and SessionRequestRetryDelay from the
+ * [OnlineSubsystemDrift] ini section.
+ *
+ * Tasks go through the serial in queue, so session operations complete in the order they were issued.
+ * A task that a later call made moot, such as ending a session that is being destroyed, gives up
+ * instead of holding that call up with its retries.
+ */
+class FOnlineAsyncTaskDriftRequest : public FOnlineAsyncTaskBasic<FOnlineSubsystemDrift>
+{
+public:
+    /**
+     * @param InSubsystem owning subsystem
+     * @param bInRetryOnTimeout false for requests that mustn't be sent twice, where a timeout may hide a success
+     */
+    FOnlineAsyncTaskDriftRequest(FOnlineSubsystemDrift* InSubsystem, bool bInRetryOnTimeout = true);
+    virtual ~FOnlineAsyncTaskDriftRequest();
+
+    /**
+     * @return false if there's nothing to tell the backend, the task then succeeds right away
+     */
+    virtual bool HasRequest() const { return true; }
+
+    /**
+     * Checked on the online thread before every attempt and while waiting,
+     * a superseded task abandons its request and fails so the tasks queued behind it can run
+     *
+     * @return true if a later call made the outcome of this task moot
+     */
+    virtual bool IsSuperseded() const { return false; }
+
+    /**
+     * Send the request to Drift
+     * Called on the game thread while the task is being ticked on the online thread,
+     * so it may only read data that doesn't change after construction.
+     * Callbacks must not capture the task, which may be gone by the time they run.
+     *
+     * @param Drift the Drift API
+     * @param Request to respond to when Drift calls back
+     */
+    virtual void SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request) {}
+
+    // FOnlineAsyncTask
+    virtual void Tick() override;
+
+protected:
+    /** The last attempt got no response in time */
+    bool bTimedOut;
+
+    int32 NumAttempts;
+
+private:
+    void SendAttempt(double Now);
+    void RetryLater(double Now);
+    /** Give up on the attempt in flight */
+    void Abandon();
+    void Complete(bool bSuccess);
+
+    const bool bRetryOnTimeout;
+    const float Timeout;
+    const int32 MaxAttempts;
+    const float RetryDelay;
+
+    /** The attempt in flight, if any */
+    TSharedPtr<FDriftRequestState, ESPMode::ThreadSafe> Request;
+
+    /** When the attempt in flight was sent, or when the next one is due */
+    double AttemptTime;
+};
+
+
+/**
+ * Async task for creating a Drift online session, registers a match with the backend
+ */
+class FOnlineAsyncTaskDriftCreateSession : public FOnlineAsyncTaskDriftRequest
+{
+public:
+    FOnlineAsyncTaskDriftCreateSession(FOnlineSubsystemDrift* InSubsystem, FName InSessionName);
+
+    virtual FString ToString() const override;
+    virtual bool IsSuperseded() const override;
+    virtual void SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request) override;
+    virtual void Finalize() override;
+    virtual void TriggerDelegates() override;
+
+private:
+    FName SessionName;
+};
+
+
+/**
+ * Async task for starting a Drift online session, tells the backend the match is running
+ */
+class FOnlineAsyncTaskDriftStartSession : public FOnlineAsyncTaskDriftRequest
+{
+public:
+    FOnlineAsyncTaskDriftStartSession(FOnlineSubsystemDrift* InSubsystem, FName InSessionName);
+
+    virtual FString ToString() const override;
+    /** Only servers have a match to update */
+    virtual bool HasRequest() const override { return IsRunningDedicatedServer(); }
+    virtual bool IsSuperseded() const override;
+    virtual void SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request) override;
+    virtual void Finalize() override;
+    virtual void TriggerDelegates() override;
+
+private:
+    FName SessionName;
+};
+
+
+/**
+ * Async task for ending a Drift online session
+ */
+class FOnlineAsyncTaskDriftEndSession : public FOnlineAsyncTaskDriftRequest
+{
+public:
+    FOnlineAsyncTaskDriftEndSession(FOnlineSubsystemDrift* InSubsystem, FName InSessionName);
+
+    virtual FString ToString() const override;
+    /** Only servers have a match to update */
+    virtual bool HasRequest() const override { return IsRunningDedicatedServer(); }
+    virtual bool IsSuperseded() const override;
+    virtual void SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request) override;
+    virtual void Finalize() override;
+    virtual void TriggerDelegates() override;
+
+private:
+    FName SessionName;
+};
+
+
+/**
+ * Async task for destroying a Drift online session
+ * The session is removed even if the backend couldn't be told, there is nothing left to retry with
+ */
+class FOnlineAsyncTaskDriftDestroySession : public FOnlineAsyncTaskDriftRequest
+{
+public:
+    FOnlineAsyncTaskDriftDestroySession(FOnlineSubsystemDrift* InSubsystem, FName InSessionName, const FOnDestroySessionCompleteDelegate& InCompletionDelegate);
+
+    virtual FString ToString() const override;
+    /** Only servers have a match to update */
+    virtual bool HasRequest() const override { return IsRunningDedicatedServer(); }
+    virtual void SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request) override;
+    virtual void Finalize() override;
+    virtual void TriggerDelegates() override;
+
+private:
+    FName SessionName;
+    FOnDestroySessionCompleteDelegate CompletionDelegate;
+    bool bSessionRemoved;
+};
+
+
+/**
+ * Async task for joining a Drift online session found by a search or matchmaking
+ */
+class FOnlineAsyncTaskDriftJoinSession : public FOnlineAsyncTaskDriftRequest
+{
+public:
+    FOnlineAsyncTaskDriftJoinSession(FOnlineSubsystemDrift* InSubsystem, FName InSessionName);
+
+    virtual FString ToString() const override;
+    virtual bool HasRequest() const override { return false; }
+    virtual void Finalize() override;
+    virtual void TriggerDelegates() override;
+
+private:
+    FName SessionName;
+};
+
+
+/**
+ * Async task for entering the match queue, on our own, by inviting a friend, or by accepting an invite
+ */
+class FOnlineAsyncTaskDriftJoinMatchQueue : public FOnlineAsyncTaskDriftRequest
+{
+public:
+    enum class EMode
+    {
+        Join,
+        Invite,
+        AcceptInvite,
+    };
+
+    /**
+     * @param InMode how to enter the queue
+     * @param InArgument friend id for Invite, invite token for AcceptInvite
+     */
+    FOnlineAsyncTaskDriftJoinMatchQueue(FOnlineSubsystemDrift* InSubsystem, FName InSessionName, EMode InMode, const FString& InArgument = FString());
+
+    virtual FString ToString() const override;
+    /** Matchmaking was cancelled since, the leave request reports the outcome */
+    virtual bool IsSuperseded() const override;
+    virtual void SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request) override;
+    virtual void TriggerDelegates() override;
+
+private:
+    FName SessionName;
+    EMode Mode;
+    FString Argument;
+
+    /** FOnlineSessionDrift::MatchQueueGeneration when matchmaking started */
+    int32 MatchQueueGeneration;
+
+    /** Filled in on the game thread by the Drift callback */
+    TSharedRef<FMatchQueueStatus, ESPMode::ThreadSafe> Status;
+};
+
+
+/**
+ * Async task for leaving the match queue
+ */
+class FOnlineAsyncTaskDriftLeaveMatchQueue : public FOnlineAsyncTaskDriftRequest
+{
+public:
+    FOnlineAsyncTaskDriftLeaveMatchQueue(FOnlineSubsystemDrift* InSubsystem, FName InSessionName);
+
+    virtual FString ToString() const override;
+    virtual void SendRequest(IDriftAPI& Drift, const FDriftRequestStateRef& Request) override;
+    virtual void TriggerDelegates() override;
+
+private:
+    FName SessionName;
+};
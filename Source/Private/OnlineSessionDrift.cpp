@@ -6,13 +6,55 @@
 #include "OnlineSubsystemDrift.h"
 #include "OnlineSubsystemUtils.h"
 #include "OnlineAsyncTaskManagerDrift.h"
+#include "OnlineAsyncTasksDrift.h"
+#include "DriftSearchResultBuilder.h"
 #include "SocketSubsystem.h"
+#include "Async/Async.h"
 
 #include "DriftAPI.h"
 
 #include "VoiceInterface.h"
 
 
+/** Match id of the placeholder in a match list that Drift hasn't filled in yet, real ids are positive */
+static const int32 MatchListMarkerId = INDEX_NONE;
+
+/** Parse a dotted IPv4 address such as "10.0.0.1", without going through the socket subsystem */
+static bool ParseIPv4(const FString& Host, uint32& OutIp)
+{
+    uint32 Ip = 0;
+    int32 NumOctets = 0;
+    int32 Octet = -1;
+    for (const TCHAR Char : Host)
+    {
+        if (Char >= TEXT('0') && Char <= TEXT('9'))
+        {
+            Octet = (Octet < 0 ? 0 : Octet * 10) + (Char - TEXT('0'));
+            if (Octet > 255)
+            {
+                return false;
+            }
+        }
+        else if (Char == TEXT('.') && Octet >= 0 && NumOctets < 3)
+        {
+            Ip = (Ip << 8) | Octet;
+            ++NumOctets;
+            Octet = -1;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (Octet < 0 || NumOctets != 3)
+    {
+        return false;
+    }
+    OutIp = (Ip << 8) | Octet;
+    return true;
+}
+
+
 FOnlineSessionInfoDrift::FOnlineSessionInfoDrift()
 : SessionId{ TEXT("INVALID") }
 {
@@ -22,206 +64,116 @@ void FOnlineSessionInfoDrift::Init(const FOnlineSubsystemDrift& Subsystem)
 {
     FGuid OwnerGuid;
     FPlatformMisc::CreateGuid(OwnerGuid);
-    SessionId = FUniqueNetIdString(OwnerGuid.ToString());
+    SetSessionId(OwnerGuid.ToString());
 }
 
-/**
- *    Async task for ending a Drift online session
- */
-class FOnlineAsyncTaskDriftEndSession : public FOnlineAsyncTaskBasic<FOnlineSubsystemDrift>
+void FOnlineSessionInfoDrift::SetMatchId(int32 MatchId)
 {
-private:
-    /** Name of session ending */
-    FName SessionName;
-
-public:
-    FOnlineAsyncTaskDriftEndSession(class FOnlineSubsystemDrift* InSubsystem, FName InSessionName) :
-        FOnlineAsyncTaskBasic(InSubsystem),
-        SessionName(InSessionName)
-    {
-    }
-
-    ~FOnlineAsyncTaskDriftEndSession()
-    {
-    }
-
-    /**
-     *    Get a human readable description of task
-     */
-    virtual FString ToString() const override
-    {
-        return FString::Printf(TEXT("FOnlineAsyncTaskDriftEndSession bWasSuccessful: %d SessionName: %s"), bWasSuccessful, *SessionName.ToString());
-    }
-
-    /**
-     * Give the async task time to do its work
-     * Can only be called on the async task manager thread
-     */
-    virtual void Tick() override
-    {
-        bIsComplete = true;
-        bWasSuccessful = true;
-    }
+    Data.MatchId = static_cast<uint32>(MatchId);
+    SetSessionId(FString::FromInt(MatchId));
+}
 
-    /**
-     * Give the async task a chance to marshal its data back to the game thread
-     * Can only be called on the game thread by the async task manager
-     */
-    virtual void Finalize() override
-    {
-        IOnlineSessionPtr SessionInt = Subsystem->GetSessionInterface();
-        FNamedOnlineSession* Session = SessionInt->GetNamedSession(SessionName);
-        if (Session)
-        {
-            Session->SessionState = EOnlineSessionState::Ended;
-        }
-    }
+void FOnlineSessionInfoDrift::SetUrl(const FString& InUrl)
+{
+    Url = InUrl;
+    Data.Ip = 0;
+    Data.Port = 0;
 
-    /**
-     *    Async task is given a chance to trigger it's delegates
-     */
-    virtual void TriggerDelegates() override
+    FString Host;
+    int32 Port = 0;
+    uint32 Ip = 0;
+    if (DriftParseConnectionUrl(Url, Host, Port) && ParseIPv4(Host, Ip))
     {
-        IOnlineSessionPtr SessionInt = Subsystem->GetSessionInterface();
-        if (SessionInt.IsValid())
-        {
-            SessionInt->TriggerOnEndSessionCompleteDelegates(SessionName, bWasSuccessful);
-        }
+        Data.Ip = Ip;
+        Data.Port = static_cast<uint16>(Port);
     }
-};
+}
 
-/**
- *    Async task for destroying a Drift online session
- */
-class FOnlineAsyncTaskDriftDestroySession : public FOnlineAsyncTaskBasic<FOnlineSubsystemDrift>
+void FOnlineSessionInfoDrift::SetResolvedAddress(const FInternetAddr& Address)
 {
-private:
-    /** Name of session ending */
-    FName SessionName;
+    uint32 Ip = 0;
+    int32 Port = 0;
+    Address.GetIp(Ip);
+    Address.GetPort(Port);
+    Data.Ip = Ip;
+    Data.Port = static_cast<uint16>(Port);
+}
 
-public:
-    FOnlineAsyncTaskDriftDestroySession(class FOnlineSubsystemDrift* InSubsystem, FName InSessionName) :
-        FOnlineAsyncTaskBasic(InSubsystem),
-        SessionName(InSessionName)
+bool FOnlineSessionInfoDrift::SetBytes(const uint8* Bytes, int32 Size)
+{
+    if (Bytes == nullptr || Size != sizeof(FDriftSessionInfoData))
     {
+        return false;
     }
 
-    ~FOnlineAsyncTaskDriftDestroySession()
-    {
-    }
+    FMemory::Memcpy(&Data, Bytes, sizeof(FDriftSessionInfoData));
+    SessionId = FUniqueNetIdString(Data.MatchId != 0 ? FString::FromInt(Data.MatchId) : FString::Printf(TEXT("%08x"), Data.SessionKey));
+    Url = Data.Ip != 0 ? GetConnectString() : FString();
+    return true;
+}
 
-    /**
-     *    Get a human readable description of task
-     */
-    virtual FString ToString() const override
+FString FOnlineSessionInfoDrift::GetConnectString() const
+{
+    if (Data.Ip == 0)
     {
-        return FString::Printf(TEXT("FOnlineAsyncTaskDriftDestroySession bWasSuccessful: %d SessionName: %s"), bWasSuccessful, *SessionName.ToString());
+        return Url;
     }
 
-    /**
-     * Give the async task time to do its work
-     * Can only be called on the async task manager thread
-     */
-    virtual void Tick() override
+    FString Result = FString::Printf(TEXT("%u.%u.%u.%u:%u"),
+        (Data.Ip >> 24) & 0xff, (Data.Ip >> 16) & 0xff, (Data.Ip >> 8) & 0xff, Data.Ip & 0xff, Data.Port);
+    int32 OptionsStart = INDEX_NONE;
+    if (Url.FindChar(TEXT('?'), OptionsStart))
     {
-        bIsComplete = true;
-        bWasSuccessful = true;
+        Result += Url.Mid(OptionsStart);
     }
+    return Result;
+}
 
-    /**
-     * Give the async task a chance to marshal its data back to the game thread
-     * Can only be called on the game thread by the async task manager
-     */
-    virtual void Finalize() override
-    {
-        IOnlineSessionPtr SessionInt = Subsystem->GetSessionInterface();
-        if (SessionInt.IsValid())
-        {
-            FNamedOnlineSession* Session = SessionInt->GetNamedSession(SessionName);
-            if (Session)
-            {
-                SessionInt->RemoveNamedSession(SessionName);
-            }
-        }
-    }
+void FOnlineSessionInfoDrift::SetSessionId(const FString& InSessionId)
+{
+    SessionId = FUniqueNetIdString(InSessionId);
+    Data.SessionKey = FCrc::StrCrc32(*InSessionId);
+}
 
-    /**
-     *    Async task is given a chance to trigger it's delegates
-     */
-    virtual void TriggerDelegates() override
+FOnlineSessionDrift::~FOnlineSessionDrift()
+{
+    if (onGotActiveMatchesHandle.IsValid())
     {
-        IOnlineSessionPtr SessionInt = Subsystem->GetSessionInterface();
-        if (SessionInt.IsValid())
+        if (auto drift = DriftSubsystem->GetDrift())
         {
-            SessionInt->TriggerOnDestroySessionCompleteDelegates(SessionName, bWasSuccessful);
+            drift->OnGotActiveMatches().Remove(onGotActiveMatchesHandle);
         }
     }
-};
+}
 
 FNamedOnlineSession* FOnlineSessionDrift::AddNamedSession(FName SessionName, const FOnlineSessionSettings& SessionSettings)
 {
-    FScopeLock ScopeLock(&SessionLock);
-    return new (Sessions) FNamedOnlineSession(SessionName, SessionSettings);
+    return Sessions.Add(SessionName, SessionSettings);
 }
 
 class FNamedOnlineSession* FOnlineSessionDrift::AddNamedSession(FName SessionName, const FOnlineSession& Session)
 {
-    FScopeLock ScopeLock(&SessionLock);
-    return new (Sessions) FNamedOnlineSession(SessionName, Session);
+    return Sessions.Add(SessionName, Session);
 }
 
 FNamedOnlineSession* FOnlineSessionDrift::GetNamedSession(FName SessionName)
 {
-    FScopeLock ScopeLock(&SessionLock);
-    for (int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++)
-    {
-        if (Sessions[SearchIndex].SessionName == SessionName)
-        {
-            return &Sessions[SearchIndex];
-        }
-    }
-    return nullptr;
+    return Sessions.Find(SessionName);
 }
 
 void FOnlineSessionDrift::RemoveNamedSession(FName SessionName)
 {
-    FScopeLock ScopeLock(&SessionLock);
-    for (int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++)
-    {
-        if (Sessions[SearchIndex].SessionName == SessionName)
-        {
-            Sessions.RemoveAtSwap(SearchIndex);
-            return;
-        }
-    }
+    Sessions.Remove(SessionName);
 }
 
 EOnlineSessionState::Type FOnlineSessionDrift::GetSessionState(FName SessionName) const
 {
-    FScopeLock ScopeLock(&SessionLock);
-    for (int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++)
-    {
-        if (Sessions[SearchIndex].SessionName == SessionName)
-        {
-            return Sessions[SearchIndex].SessionState;
-        }
-    }
-
-    return EOnlineSessionState::NoSession;
+    return Sessions.GetState(SessionName);
 }
 
 bool FOnlineSessionDrift::HasPresenceSession()
 {
-    FScopeLock ScopeLock(&SessionLock);
-    for (int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++)
-    {
-        if (Sessions[SearchIndex].SessionSettings.bUsesPresence)
-        {
-            return true;
-        }
-    }
-
-    return false;
+    return Sessions.HasPresenceSession();
 }
 
 bool FOnlineSessionDrift::CreateSession(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
@@ -231,42 +183,34 @@ bool FOnlineSessionDrift::CreateSession(int32 HostingPlayerNum, FName SessionNam
     FNamedOnlineSession* Session = GetNamedSession(SessionName);
     if (Session == nullptr)
     {
-        Session = AddNamedSession(SessionName, NewSessionSettings);
-        check(Session);
-        Session->SessionState = EOnlineSessionState::Creating;
-        Session->NumOpenPrivateConnections = NewSessionSettings.NumPrivateConnections;
-        Session->NumOpenPublicConnections = NewSessionSettings.NumPublicConnections;
+        if (DriftSubsystem->GetDrift())
+        {
+            Session = AddNamedSession(SessionName, NewSessionSettings);
+            check(Session);
+            Sessions.SetState(*Session, EOnlineSessionState::Creating);
+            Session->NumOpenPrivateConnections = NewSessionSettings.NumPrivateConnections;
+            Session->NumOpenPublicConnections = NewSessionSettings.NumPublicConnections;
 
-        Session->HostingPlayerNum = HostingPlayerNum;
+            Session->HostingPlayerNum = HostingPlayerNum;
 
-        check(DriftSubsystem);
+            Session->SessionSettings.BuildUniqueId = GetBuildUniqueId();
 
-        Session->SessionSettings.BuildUniqueId = GetBuildUniqueId();
+            if (IsRunningDedicatedServer())
+            {
+                // Lets clients measure their latency to us, if a probe port is configured
+                LatencyEchoResponder.Start();
+            }
 
-        FOnlineSessionInfoDrift* NewSessionInfo = new FOnlineSessionInfoDrift();
-        NewSessionInfo->Init(*DriftSubsystem);
-        Session->SessionInfo = MakeShareable(NewSessionInfo);
-        
-        if (auto Drift = DriftSubsystem->GetDrift())
-        {
-            // TODO: Use actual settings, but backend only really works with 2 players now
-            onMatchAddedDelegateHandle = Drift->OnMatchAdded().AddRaw(this, &FOnlineSessionDrift::OnMatchAdded);
-            Drift->AddMatch(TEXT(""), TEXT(""), 1, 2);
+            FOnlineSessionInfoDrift* NewSessionInfo = new FOnlineSessionInfoDrift();
+            NewSessionInfo->Init(*DriftSubsystem);
+            Session->SessionInfo = MakeShareable(NewSessionInfo);
+
+            DriftSubsystem->QueueAsyncTask(new FOnlineAsyncTaskDriftCreateSession(DriftSubsystem, SessionName));
             Result = ERROR_IO_PENDING;
         }
-
-        if (Result != ERROR_IO_PENDING)
+        else
         {
-            Session->SessionState = EOnlineSessionState::Pending;
-
-            if (Result != ERROR_SUCCESS)
-            {
-                RemoveNamedSession(SessionName);
-            }
-            else
-            {
-                RegisterLocalPlayers(Session);
-            }
+            UE_LOG_ONLINE(Warning, TEXT("Cannot create session '%s': Drift is not available."), *SessionName.ToString());
         }
     }
     else
@@ -289,22 +233,6 @@ bool FOnlineSessionDrift::CreateSession(const FUniqueNetId& HostingPlayerId, FNa
 }
 
 
-void FOnlineSessionDrift::OnMatchAdded(bool success)
-{
-    auto Session = GetNamedSession(GameSessionName);
-    if (Session)
-    {
-        Session->SessionState = EOnlineSessionState::Pending;
-    }
-    if (auto Drift = DriftSubsystem->GetDrift())
-    {
-        Drift->OnMatchAdded().Remove(onMatchAddedDelegateHandle);
-    }
-    onMatchAddedDelegateHandle.Reset();
-    TriggerOnCreateSessionCompleteDelegates(GameSessionName, (Session != nullptr) && success);
-}
-
-
 bool FOnlineSessionDrift::StartSession(FName SessionName)
 {
     uint32 Result = E_FAIL;
@@ -315,12 +243,9 @@ bool FOnlineSessionDrift::StartSession(FName SessionName)
         if (Session->SessionState == EOnlineSessionState::Pending ||
             Session->SessionState == EOnlineSessionState::Ended)
         {
-            Session->SessionState = EOnlineSessionState::InProgress;
-            if (auto Drift = DriftSubsystem->GetDrift())
-            {
-                Drift->UpdateServer(TEXT("running"), TEXT(""), FDriftServerStatusUpdatedDelegate{});
-                Drift->UpdateMatch(TEXT("started"), TEXT(""), FDriftMatchStatusUpdatedDelegate{});
-            }
+            Sessions.SetState(*Session, EOnlineSessionState::Starting);
+            DriftSubsystem->QueueAsyncTask(new FOnlineAsyncTaskDriftStartSession(DriftSubsystem, SessionName));
+            Result = ERROR_IO_PENDING;
         }
         else
         {
@@ -344,17 +269,18 @@ bool FOnlineSessionDrift::StartSession(FName SessionName)
 
 bool FOnlineSessionDrift::UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData)
 {
-    bool bWasSuccessful = true;
-
     auto Session = GetNamedSession(SessionName);
     if (Session)
     {
-        // TODO: What should this do?
+        // Drift's match and server updates only carry a status, there is no endpoint for settings
         Session->SessionSettings = UpdatedSessionSettings;
-        TriggerOnUpdateSessionCompleteDelegates(SessionName, bWasSuccessful);
+        TriggerOnUpdateSessionCompleteDelegates(SessionName, true);
+        return true;
     }
 
-    return bWasSuccessful;
+    UE_LOG_ONLINE(Warning, TEXT("Can't update session (%s) that hasn't been created"), *SessionName.ToString());
+    TriggerOnUpdateSessionCompleteDelegates(SessionName, false);
+    return false;
 }
 
 bool FOnlineSessionDrift::EndSession(FName SessionName)
@@ -367,14 +293,9 @@ bool FOnlineSessionDrift::EndSession(FName SessionName)
         // Can't end a match that isn't in progress
         if (Session->SessionState == EOnlineSessionState::InProgress)
         {
-            Session->SessionState = EOnlineSessionState::Ended;
-            if (IsRunningDedicatedServer())
-            {
-                if (auto Drift = DriftSubsystem->GetDrift())
-                {
-                    Drift->UpdateMatch(TEXT("ended"), TEXT(""), FDriftMatchStatusUpdatedDelegate{});
-                }
-            }
+            Sessions.SetState(*Session, EOnlineSessionState::Ending);
+            DriftSubsystem->QueueAsyncTask(new FOnlineAsyncTaskDriftEndSession(DriftSubsystem, SessionName));
+            Result = ERROR_IO_PENDING;
         }
         else
         {
@@ -391,11 +312,6 @@ bool FOnlineSessionDrift::EndSession(FName SessionName)
 
     if (Result != ERROR_IO_PENDING)
     {
-        if (Session)
-        {
-            Session->SessionState = EOnlineSessionState::Ended;
-        }
-
         TriggerOnEndSessionCompleteDelegates(SessionName, (Result == ERROR_SUCCESS) ? true : false);
     }
 
@@ -409,14 +325,15 @@ bool FOnlineSessionDrift::DestroySession(FName SessionName, const FOnDestroySess
     FNamedOnlineSession* Session = GetNamedSession(SessionName);
     if (Session)
     {
-        // The session info is no longer needed
-        RemoveNamedSession(Session->SessionName);
-        if (IsRunningDedicatedServer())
+        if (Session->SessionState != EOnlineSessionState::Destroying)
         {
-            if (auto Drift = DriftSubsystem->GetDrift())
-            {
-                Drift->UpdateMatch(TEXT("completed"), TEXT(""), FDriftMatchStatusUpdatedDelegate{});
-            }
+            Sessions.SetState(*Session, EOnlineSessionState::Destroying);
+            DriftSubsystem->QueueAsyncTask(new FOnlineAsyncTaskDriftDestroySession(DriftSubsystem, SessionName, CompletionDelegate));
+            Result = ERROR_IO_PENDING;
+        }
+        else
+        {
+            UE_LOG_ONLINE(Warning, TEXT("Already in process of destroying session (%s)"), *SessionName.ToString());
         }
     }
     else
@@ -435,7 +352,9 @@ bool FOnlineSessionDrift::DestroySession(FName SessionName, const FOnDestroySess
 
 bool FOnlineSessionDrift::IsPlayerInSession(FName SessionName, const FUniqueNetId& UniqueId)
 {
-    return IsPlayerInSessionImpl(this, SessionName, UniqueId);
+    FDriftRegisteredPlayerIndex* PlayerIndex = nullptr;
+    FNamedOnlineSession* Session = Sessions.Find(SessionName, PlayerIndex);
+    return Session && PlayerIndex->Find(*Session, UniqueId) != INDEX_NONE;
 }
 
 bool FOnlineSessionDrift::StartMatchmaking(const TArray< TSharedRef<const FUniqueNetId> >& LocalPlayers, FName SessionName, const FOnlineSessionSettings& NewSessionSettings, TSharedRef<FOnlineSessionSearch>& SearchSettings)
@@ -445,33 +364,43 @@ bool FOnlineSessionDrift::StartMatchmaking(const TArray< TSharedRef<const FUniqu
      * unless we rewrite the backend to deal with sessions in some other way, or Epic alters the interface.
      */
 
-    // TODO: Consider at least some of the settings passed in
+    FDriftMatchQueueTicket Ticket{ LocalPlayers, NewSessionSettings };
+    FString TicketError;
+    if (!Ticket.Validate(TicketError))
+    {
+        UE_LOG_ONLINE(Warning, TEXT("Can't start matchmaking for session (%s): %s"), *SessionName.ToString(), *TicketError);
+        return false;
+    }
 
     CurrentSearch.Reset();
     SearchSettings->SearchResults.Empty();
 
-    if (auto drift = DriftSubsystem->GetDrift())
+    if (DriftSubsystem->GetDrift())
     {
+        UE_LOG_ONLINE(Log, TEXT("Matchmaking for session (%s) with ticket %s"), *SessionName.ToString(), *Ticket.ToString());
+
         SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
         CurrentSessionSearch = SearchSettings;
         CurrentSessionSearchName = SessionName;
+        // Local players share our Drift login, the whole group is queued by the one request
+        CurrentMatchQueueTicket = MoveTemp(Ticket);
+        MatchmakingStats.OnStarted();
         FString friendId;
         FString token;
+        FOnlineAsyncTaskDriftJoinMatchQueue* Task;
         if (SearchSettings->QuerySettings.Get(TEXT("friend_id"), friendId))
         {
-            FUniqueNetIdDrift driftId{ friendId };
-            drift->InvitePlayerToMatch(driftId.GetId(), FDriftJoinedMatchQueueDelegate::CreateRaw(this, &FOnlineSessionDrift::OnJoinedMatchQueue));
+            Task = new FOnlineAsyncTaskDriftJoinMatchQueue(DriftSubsystem, SessionName, FOnlineAsyncTaskDriftJoinMatchQueue::EMode::Invite, friendId);
         }
         else if (SearchSettings->QuerySettings.Get(TEXT("invite_token"), token))
         {
-            FMatchInvite invite;
-            invite.token = token;
-            drift->AcceptMatchInvite(invite, FDriftJoinedMatchQueueDelegate::CreateRaw(this, &FOnlineSessionDrift::OnJoinedMatchQueue));
+            Task = new FOnlineAsyncTaskDriftJoinMatchQueue(DriftSubsystem, SessionName, FOnlineAsyncTaskDriftJoinMatchQueue::EMode::AcceptInvite, token);
         }
         else
         {
-            drift->JoinMatchQueue(FDriftJoinedMatchQueueDelegate::CreateRaw(this, &FOnlineSessionDrift::OnJoinedMatchQueue));
+            Task = new FOnlineAsyncTaskDriftJoinMatchQueue(DriftSubsystem, SessionName, FOnlineAsyncTaskDriftJoinMatchQueue::EMode::Join);
         }
+        DriftSubsystem->QueueAsyncTask(Task);
         return true;
     }
 
@@ -483,18 +412,23 @@ bool FOnlineSessionDrift::StartMatchmaking(const TArray< TSharedRef<const FUniqu
 
 void FOnlineSessionDrift::OnJoinedMatchQueue(bool success, const FMatchQueueStatus& status)
 {
+    if (!CurrentSessionSearch.IsValid())
+    {
+        // Cancelled while the request was in flight
+        return;
+    }
+
+    MatchmakingStats.OnJoinedQueue(success);
     if (success)
     {
-        CurrentSearch = MakeShareable(new FMatchQueueSearch(DriftSubsystem));
+        CurrentSearch = MakeShareable(new FMatchQueueSearch(DriftSubsystem, MatchmakingStats));
         CurrentSearch->OnMatchQueueStatusChanged().AddRaw(this, &FOnlineSessionDrift::OnMatchSearchStatusChanged);
     }
     else
     {
+        MatchmakingStats.OnFailed();
         CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
-        if (CurrentSessionSearch.IsValid())
-        {
-            CurrentSessionSearch = nullptr;
-        }
+        CurrentSessionSearch = nullptr;
         TriggerOnMatchmakingCompleteDelegates(CurrentSessionSearchName, false);
     }
 }
@@ -506,26 +440,27 @@ void FOnlineSessionDrift::OnMatchSearchStatusChanged(FName status)
     {
         if (status == TEXT("matched"))
         {
-            auto NewResult = new (CurrentSessionSearch->SearchResults) FOnlineSessionSearchResult{};
-            auto& NewSession = NewResult->Session;
-            auto DriftSessionInfo = new FOnlineSessionInfoDrift{};
-            NewSession.SessionInfo = MakeShareable(DriftSessionInfo);
-            auto match = CurrentSearch->GetCurrentMatch();
-            DriftSessionInfo->Url = match.ue4_connection_url;
-            auto& SessionSettings = NewSession.SessionSettings;
-            SessionSettings.bAllowInvites = false;
-            SessionSettings.bAllowJoinInProgress = false;
-            SessionSettings.bAllowJoinViaPresence = false;
-            SessionSettings.bAllowJoinViaPresenceFriendsOnly = false;
-            SessionSettings.bAntiCheatProtected = false;
-            SessionSettings.bIsDedicated = true;
-            SessionSettings.bIsLANMatch = false;
-            SessionSettings.bShouldAdvertise = false;
-            SessionSettings.BuildUniqueId = 0;
-            SessionSettings.bUsesPresence = false;
-            SessionSettings.bUsesStats = false;
-            SessionSettings.NumPrivateConnections = 0;
-            SessionSettings.NumPublicConnections = 2;   // TODO: Fill in from result
+            const auto& Match = CurrentSearch->GetCurrentMatch();
+            MatchmakingStats.OnMatched(CurrentSearch->GetPollStats());
+            RecentMatches.Add(Match);
+            MatchmadeMatchId = Match.match_id;
+            if (!CurrentMatchQueueTicket.Fits(Match))
+            {
+                UE_LOG_ONLINE(Warning, TEXT("Matched into %d, which doesn't fit ticket %s"), Match.match_id, *CurrentMatchQueueTicket.ToString());
+            }
+            FDriftSearchResultBuilder Builder{ CurrentSessionSearch->SearchResults, 1 };
+            auto& Result = Builder.Add(Match);
+            CurrentMatchQueueTicket.ApplyTo(Result.Session.SessionSettings, Match);
+
+            if (ConnectionPrewarmer.IsEnabled())
+            {
+                ConnectionPrewarmer.Prewarm(Match.ue4_connection_url);
+                if (ConnectionPrewarmer.WantsHandshake())
+                {
+                    // The latency probe doubles as the handshake, its PingInMs tells if the server is reachable
+                    PingSearchResults(CurrentSessionSearch.ToSharedRef(), CurrentSessionSearch->SearchResults.Num() - 1, 1);
+                }
+            }
 
             CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Done;
             CurrentSessionSearch.Reset();
@@ -535,6 +470,7 @@ void FOnlineSessionDrift::OnMatchSearchStatusChanged(FName status)
         }
         else if (status == TEXT("timedout") || status == TEXT("usurped"))
         {
+            MatchmakingStats.OnFailed();
             CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
             CurrentSessionSearch.Reset();
             CurrentSearch.Reset();
@@ -544,34 +480,97 @@ void FOnlineSessionDrift::OnMatchSearchStatusChanged(FName status)
     }
 }
 
-bool FOnlineSessionDrift::CancelMatchmaking(int32 SearchingPlayerNum, FName SessionName)
+void FOnlineSessionDrift::OnMatchQueueStatusPushed(const FMatchQueueStatus& status)
 {
-    if (!CurrentSessionSearch.IsValid())
+    if (CurrentSearch.IsValid())
     {
-        TriggerOnCancelMatchmakingCompleteDelegates(SessionName, true);
+        // Listeners reset CurrentSearch once the queue is done with, keep it alive until the push is applied
+        TSharedPtr<FMatchQueueSearch> Search = CurrentSearch;
+        Search->OnStatusPushed(status);
+    }
+    else
+    {
+        UE_LOG_ONLINE(Verbose, TEXT("Ignoring pushed match queue status '%s' while not in a queue"), *status.status.ToString());
+    }
+}
+
+bool FOnlineSessionDrift::HandleMatchQueueExecCommands(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar)
+{
+    if (FParse::Command(&Cmd, TEXT("PUSH")))
+    {
+        FMatchQueueStatus status;
+        status.status = FName(*FParse::Token(Cmd, false));
+        status.match.ue4_connection_url = FParse::Token(Cmd, false);
+        OnMatchQueueStatusPushed(status);
+        return true;
+    }
+    else if (FParse::Command(&Cmd, TEXT("STATS")))
+    {
+        if (FParse::Command(&Cmd, TEXT("RESET")))
+        {
+            MatchmakingStats.Reset();
+        }
+        MatchmakingStats.Dump(Ar);
         return true;
     }
+    return false;
+}
 
-    if (auto drift = DriftSubsystem->GetDrift())
+bool FOnlineSessionDrift::HandleSessionStateExecCommands(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar)
+{
+    FDriftSessionStateSnapshot Snapshot;
+    CaptureSessionState(Snapshot);
+    Ar.Log(Snapshot.ToJson());
+    return true;
+}
+
+bool FOnlineSessionDrift::HandleSearchResultsExecCommands(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar)
+{
+    if (FParse::Command(&Cmd, TEXT("BENCH")))
     {
-        drift->LeaveMatchQueue(FDriftLeftMatchQueueDelegate::CreateLambda([this, SessionName](bool success)
+        const FString CountStr = FParse::Token(Cmd, false);
+        const int32 Count = CountStr.IsEmpty() ? 10000 : FMath::Max(FCString::Atoi(*CountStr), 1);
+
+        FMatchesSearch Matches;
+        Matches.matches.SetNum(Count);
+        for (int32 Index = 0; Index < Count; ++Index)
         {
-            if (success)
-            {
-                CurrentSearch.Reset();
-                if (CurrentSessionSearch.IsValid())
-                {
-                    CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
-                    CurrentSessionSearch.Reset();
-                }
-                TriggerOnCancelMatchmakingCompleteDelegates(SessionName, true);
-            }
-            else
+            Matches.matches[Index].ue4_connection_url = FString::Printf(TEXT("10.0.%d.%d:7777"), (Index >> 8) & 0xff, Index & 0xff);
+        }
+
+        TArray<FOnlineSessionSearchResult> Results;
+        const double StartTime = FPlatformTime::Seconds();
+        {
+            Results.Reserve(Count);
+            FDriftSearchResultBuilder Builder{ Results, Count };
+            for (const auto& Match : Matches.matches)
             {
-                TriggerOnCancelMatchmakingCompleteDelegates(SessionName, false);
-                return;
+                Builder.Add(Match);
             }
-        }));
+        }
+        const double BuildTime = FPlatformTime::Seconds() - StartTime;
+        Results.Empty();
+        const double TotalTime = FPlatformTime::Seconds() - StartTime;
+
+        Ar.Logf(TEXT("Built %d search results in %.3f ms (%.3f us each), %.3f ms including teardown"),
+            Count, BuildTime * 1000.0, BuildTime * 1000000.0 / Count, TotalTime * 1000.0);
+        return true;
+    }
+    return false;
+}
+
+bool FOnlineSessionDrift::CancelMatchmaking(int32 SearchingPlayerNum, FName SessionName)
+{
+    if (!CurrentSessionSearch.IsValid())
+    {
+        TriggerOnCancelMatchmakingCompleteDelegates(SessionName, true);
+        return true;
+    }
+
+    if (DriftSubsystem->GetDrift())
+    {
+        MatchQueueGeneration.Increment();
+        DriftSubsystem->QueueAsyncTask(new FOnlineAsyncTaskDriftLeaveMatchQueue(DriftSubsystem, SessionName));
         return true;
     }
 
@@ -587,145 +586,417 @@ bool FOnlineSessionDrift::CancelMatchmaking(const FUniqueNetId& SearchingPlayerI
     return CancelMatchmaking(0, SessionName);
 }
 
-bool FOnlineSessionDrift::FindSessions(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+void FOnlineSessionDrift::OnLeftMatchQueue(FName SessionName, bool success)
+{
+    if (success)
+    {
+        CurrentSearch.Reset();
+        if (CurrentSessionSearch.IsValid())
+        {
+            MatchmakingStats.OnCancelled();
+            CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
+            CurrentSessionSearch.Reset();
+        }
+    }
+    TriggerOnCancelMatchmakingCompleteDelegates(SessionName, success);
+}
+
+bool FOnlineSessionDrift::FindSessions(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+    const bool bAlreadySearching = ActiveSearches.ContainsByPredicate([&SearchSettings](const TSharedRef<FDriftSessionSearch>& Search)
+    {
+        return Search->Serves(*SearchSettings);
+    });
+    if (bAlreadySearching)
+    {
+        UE_LOG_ONLINE(Warning, TEXT("Ignoring game search request for a search that is already pending"));
+        return true;
+    }
+
+    SearchSettings->SearchResults.Empty();
+    LastSessionSearch = SearchSettings;
+    TSharedRef<FDriftSessionSearch> NewSearch = MakeShareable(new FDriftSessionSearch{ SearchSettings });
+
+    UE_LOG_ONLINE(Verbose, TEXT("Searching for matches: %s"), *NewSearch->Query.ToString());
+
+    for (const auto& Search : ActiveSearches)
+    {
+        if (Search->CanShareWith(*NewSearch))
+        {
+            // Same question, same answer
+            Search->Followers.Add(SearchSettings);
+            SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+            return true;
+        }
+    }
+
+    if (CachedActiveMatches.IsValid() && FPlatformTime::Seconds() - CachedActiveMatchesTime < ActiveMatchesCacheTTL)
+    {
+        // Completes on the next tick, never from inside FindSessions
+        NewSearch->SetMatches(CachedActiveMatches.ToSharedRef(), true);
+    }
+    else if (!FetchActiveMatches())
+    {
+        return false;
+    }
+
+    SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+    ActiveSearches.Add(NewSearch);
+    return true;
+}
+
+bool FOnlineSessionDrift::FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+    // This function doesn't use the SearchingPlayerNum parameter, so passing in anything is fine.
+    return FindSessions(0, SearchSettings);
+}
+
+bool FOnlineSessionDrift::FindSessionById(const FUniqueNetId& SearchingUserId, const FUniqueNetId& SessionId, const FUniqueNetId& FriendId, const FOnSingleSessionResultCompleteDelegate& CompletionDelegates)
+{
+    const int32 MatchId = FCString::Atoi(*SessionId.ToString());
+    if (MatchId > 0)
+    {
+        if (TryCompleteSessionLookup(MatchId, CompletionDelegates))
+        {
+            return true;
+        }
+
+        // There's no single match lookup in the Drift API, so refresh the match list, which also refreshes the index
+        if (FetchActiveMatches())
+        {
+            PendingSessionLookups.Add(FPendingSessionLookup{ MatchId, CompletionDelegates });
+            return true;
+        }
+    }
+    else
+    {
+        UE_LOG_ONLINE(Warning, TEXT("Invalid session id '%s' passed to FindSessionById()"), *SessionId.ToDebugString());
+    }
+
+    FOnlineSessionSearchResult EmptyResult;
+    CompletionDelegates.ExecuteIfBound(0, false, EmptyResult);
+    return false;
+}
+
+bool FOnlineSessionDrift::TryCompleteSessionLookup(int32 MatchId, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate)
+{
+    if (const auto Match = RecentMatches.Find(MatchId))
+    {
+        TArray<FOnlineSessionSearchResult> Results;
+        FDriftSearchResultBuilder Builder{ Results, 1 };
+        CompletionDelegate.ExecuteIfBound(0, true, Builder.Add(*Match));
+        return true;
+    }
+    return false;
+}
+
+bool FOnlineSessionDrift::CancelFindSessions()
+{
+    uint32 Return = E_FAIL;
+    if (ActiveSearches.Num() > 0)
+    {
+        Return = ERROR_SUCCESS;
+
+        // The interface has no way to name a search, so they all go
+        for (const auto& Search : ActiveSearches)
+        {
+            for (const auto& Follower : Search->Followers)
+            {
+                Follower->SearchState = EOnlineAsyncTaskState::Failed;
+                Follower->SearchResults.Empty();
+            }
+            Search->SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+            Search->SearchSettings->SearchResults.Empty();
+        }
+        ActiveSearches.Empty();
+        ReleaseActiveMatches();
+    }
+    else
+    {
+        UE_LOG_ONLINE(Warning, TEXT("Can't cancel a search that isn't in progress"));
+    }
+
+    if (Return != ERROR_IO_PENDING)
+    {
+        TriggerOnCancelFindSessionsCompleteDelegates(true);
+    }
+
+    return Return == ERROR_SUCCESS || Return == ERROR_IO_PENDING;
+}
+
+bool FOnlineSessionDrift::CancelFindSessions(const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+    const bool bCancelled = CancelSearch(*SearchSettings);
+    if (!bCancelled)
+    {
+        UE_LOG_ONLINE(Warning, TEXT("Can't cancel a search that isn't in progress"));
+    }
+    TriggerOnCancelFindSessionsCompleteDelegates(true);
+    return bCancelled;
+}
+
+bool FOnlineSessionDrift::CancelSearch(const FOnlineSessionSearch& SearchSettings)
+{
+    const int32 Index = ActiveSearches.IndexOfByPredicate([&SearchSettings](const TSharedRef<FDriftSessionSearch>& Search)
+    {
+        return Search->Serves(SearchSettings);
+    });
+    if (Index == INDEX_NONE)
+    {
+        return false;
+    }
+
+    if (!ActiveSearches[Index]->Cancel(SearchSettings))
+    {
+        ActiveSearches.RemoveAt(Index);
+        ReleaseActiveMatches();
+    }
+    return true;
+}
+
+void FOnlineSessionDrift::ReleaseActiveMatches()
+{
+    if (!PendingActiveMatches.IsValid() || PendingSessionLookups.Num() > 0)
+    {
+        return;
+    }
+
+    const bool bIsWaitedFor = ActiveSearches.ContainsByPredicate([](const TSharedRef<FDriftSessionSearch>& Search)
+    {
+        return !Search->HasMatches();
+    });
+    if (!bIsWaitedFor)
+    {
+        UE_LOG_ONLINE(Verbose, TEXT("Nobody is waiting for the match list any more, its response will be dropped"));
+        bPendingActiveMatchesAbandoned = true;
+    }
+}
+
+bool FOnlineSessionDrift::FetchActiveMatches()
+{
+    if (PendingActiveMatches.IsValid())
+    {
+        // Everyone waiting is served by the request already in flight, even if it was given up on
+        bPendingActiveMatchesAbandoned = false;
+        return true;
+    }
+
+    if (auto drift = DriftSubsystem->GetDrift())
+    {
+        if (!onGotActiveMatchesHandle.IsValid())
+        {
+            onGotActiveMatchesHandle = drift->OnGotActiveMatches().AddRaw(this, &FOnlineSessionDrift::OnGotActiveMatches);
+        }
+        PendingActiveMatches = MakeShareable(new FMatchesSearch{});
+        // Drift fills in the list before it broadcasts, a completion that leaves the marker alone wasn't for us
+        PendingActiveMatches->matches.AddDefaulted();
+        PendingActiveMatches->matches[0].match_id = MatchListMarkerId;
+        PendingActiveMatchesTime = FPlatformTime::Seconds();
+        auto temp = PendingActiveMatches.ToSharedRef();
+        drift->GetActiveMatches(temp);
+        return true;
+    }
+    return false;
+}
+
+void FOnlineSessionDrift::OnGotActiveMatches(bool success)
+{
+    if (!PendingActiveMatches.IsValid())
+    {
+        // Someone else asked for this list
+        return;
+    }
+
+    if (!success)
+    {
+        // Drift doesn't say whose request failed, fail ours rather than wait for it to time out
+        CompleteActiveMatches(false);
+        return;
+    }
+
+    const auto& MatchList = PendingActiveMatches->matches;
+    if (MatchList.Num() == 1 && MatchList[0].match_id == MatchListMarkerId)
+    {
+        // The completion of somebody else's request
+        return;
+    }
+
+    CompleteActiveMatches(true);
+}
+
+void FOnlineSessionDrift::CompleteActiveMatches(bool success)
 {
-    uint32 Return = E_FAIL;
+    auto Matches = PendingActiveMatches.ToSharedRef();
+    PendingActiveMatches.Reset();
+    Matches->matches.RemoveAll([](const FActiveMatch& Match)
+    {
+        return Match.match_id == MatchListMarkerId;
+    });
+    if (!success)
+    {
+        // Whatever Drift left in the list on the way to failing isn't a match list
+        Matches = MakeShareable(new FMatchesSearch{});
+    }
 
-    if (!CurrentSessionSearch.IsValid() && SearchSettings->SearchState != EOnlineAsyncTaskState::InProgress)
+    if (bPendingActiveMatchesAbandoned)
     {
-        SearchSettings->SearchResults.Empty();
-        CurrentSessionSearch = SearchSettings;
+        bPendingActiveMatchesAbandoned = false;
+        UE_LOG_ONLINE(Verbose, TEXT("Dropping match list nobody is waiting for"));
+        return;
+    }
 
-        // TODO: Actually use the search settings for something
+    if (success)
+    {
+        CachedActiveMatches = Matches;
+        CachedActiveMatchesTime = FPlatformTime::Seconds();
+        RecentMatches.SetMatchList(Matches);
+        RefreshOpenSlots();
+    }
 
-        if (auto drift = DriftSubsystem->GetDrift())
+    // The list is as fresh as it gets, lookups that still miss have no match to find
+    auto Lookups = MoveTemp(PendingSessionLookups);
+    PendingSessionLookups.Reset();
+    for (const auto& Lookup : Lookups)
+    {
+        if (!TryCompleteSessionLookup(Lookup.MatchId, Lookup.CompletionDelegate))
         {
-            onGotActiveMatchesHandle = drift->OnGotActiveMatches().AddRaw(this, &FOnlineSessionDrift::OnGotActiveMatches);
-            DriftSearch = MakeShareable(new FMatchesSearch{});
-            auto temp = DriftSearch.ToSharedRef();
-            drift->GetActiveMatches(temp);
-            Return = ERROR_IO_PENDING;
+            FOnlineSessionSearchResult EmptyResult;
+            Lookup.CompletionDelegate.ExecuteIfBound(0, false, EmptyResult);
         }
+    }
 
-        if (Return == ERROR_IO_PENDING)
+    for (const auto& Search : ActiveSearches)
+    {
+        if (!Search->HasMatches())
         {
-            SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+            Search->SetMatches(Matches, success);
         }
     }
-    else
-    {
-        UE_LOG_ONLINE(Warning, TEXT("Ignoring game search request while one is pending"));
-        Return = ERROR_IO_PENDING;
-    }
-
-    return Return == ERROR_SUCCESS || Return == ERROR_IO_PENDING;
+    TickSearches();
 }
 
-bool FOnlineSessionDrift::FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+void FOnlineSessionDrift::RefreshOpenSlots()
 {
-    // This function doesn't use the SearchingPlayerNum parameter, so passing in anything is fine.
-    return FindSessions(0, SearchSettings);
-}
+    auto Search = LastSessionSearch.Pin();
+    if (!Search.IsValid() || Search->SearchState == EOnlineAsyncTaskState::InProgress)
+    {
+        // Results still being added are built from the new list anyway
+        return;
+    }
 
-bool FOnlineSessionDrift::FindSessionById(const FUniqueNetId& SearchingUserId, const FUniqueNetId& SessionId, const FUniqueNetId& FriendId, const FOnSingleSessionResultCompleteDelegate& CompletionDelegates)
-{
-    FOnlineSessionSearchResult EmptyResult;
-    CompletionDelegates.ExecuteIfBound(0, false, EmptyResult);
-    return true;
+    for (auto& SearchResult : Search->SearchResults)
+    {
+        const auto SessionInfo = static_cast<const FOnlineSessionInfoDrift*>(SearchResult.Session.SessionInfo.Get());
+        if (SessionInfo)
+        {
+            if (const auto Match = RecentMatches.Find(static_cast<int32>(SessionInfo->GetData().MatchId)))
+            {
+                FDriftSearchResultBuilder::UpdateSlots(SearchResult.Session, *Match);
+            }
+        }
+    }
 }
 
-bool FOnlineSessionDrift::CancelFindSessions()
+bool FOnlineSessionDrift::IsSearchResultFull(const FOnlineSessionSearchResult& SearchResult) const
 {
-    uint32 Return = E_FAIL;
-    if (CurrentSessionSearch.IsValid() && CurrentSessionSearch->SearchState == EOnlineAsyncTaskState::InProgress)
-    {
-        // Make sure it's the right type
-        Return = ERROR_SUCCESS;
-
-        CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
-        CurrentSessionSearch = nullptr;
-    }
-    else
+    const auto SessionInfo = static_cast<const FOnlineSessionInfoDrift*>(SearchResult.Session.SessionInfo.Get());
+    const int32 MatchId = SessionInfo ? static_cast<int32>(SessionInfo->GetData().MatchId) : 0;
+    if (MatchId != 0 && MatchId == MatchmadeMatchId)
     {
-        UE_LOG_ONLINE(Warning, TEXT("Can't cancel a search that isn't in progress"));
+        return false;
     }
 
-    if (Return != ERROR_IO_PENDING)
+    const auto Match = MatchId != 0 ? RecentMatches.Find(MatchId) : nullptr;
+    if (Match)
     {
-        TriggerOnCancelFindSessionsCompleteDelegates(true);
+        return Match->max_players > 0 && Match->num_players >= Match->max_players;
     }
+    return SearchResult.Session.SessionSettings.NumPublicConnections > 0 && SearchResult.Session.NumOpenPublicConnections <= 0;
+}
 
-    return Return == ERROR_SUCCESS || Return == ERROR_IO_PENDING;
+void FOnlineSessionDrift::InvalidateActiveMatchesCache()
+{
+    CachedActiveMatches.Reset();
+    CachedActiveMatchesTime = 0.0;
 }
 
-void FOnlineSessionDrift::OnGotActiveMatches(bool success)
+void FOnlineSessionDrift::TickSearches()
 {
-    if (DriftSearch.IsValid())
+    // Listeners may start or cancel searches, work on a copy
+    const auto Searches = ActiveSearches;
+    for (const auto& Search : Searches)
     {
-        if (CurrentSessionSearch.IsValid())
+        if (!Search->HasMatches() || !ActiveSearches.Contains(Search))
         {
-            for (const auto& activeMatch : DriftSearch->matches)
-            {
-                auto NewResult = new (CurrentSessionSearch->SearchResults) FOnlineSessionSearchResult{};
-                auto& NewSession = NewResult->Session;
-                auto DriftSessionInfo = new FOnlineSessionInfoDrift{};
-                NewSession.SessionInfo = MakeShareable(DriftSessionInfo);
-                DriftSessionInfo->Url = activeMatch.ue4_connection_url;
-                auto& SessionSettings = NewSession.SessionSettings;
-                SessionSettings.bAllowInvites = false;
-                SessionSettings.bAllowJoinInProgress = false;
-                SessionSettings.bAllowJoinViaPresence = false;
-                SessionSettings.bAllowJoinViaPresenceFriendsOnly = false;
-                SessionSettings.bAntiCheatProtected = false;
-                SessionSettings.bIsDedicated = true;
-                SessionSettings.bIsLANMatch = false;
-                SessionSettings.bShouldAdvertise = false;
-                SessionSettings.BuildUniqueId = 0;
-                SessionSettings.bUsesPresence = false;
-                SessionSettings.bUsesStats = false;
-                SessionSettings.NumPrivateConnections = 0;
-                SessionSettings.NumPublicConnections = 2;   // TODO: Fill in from result
-            }
-            CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Done;
-            CurrentSessionSearch.Reset();
+            continue;
+        }
+
+        auto& SearchResults = Search->SearchSettings->SearchResults;
+        const int32 FirstNewResult = SearchResults.Num();
+        const bool bIsDone = Search->AddResults(Search->bStreamResults && Search->bSucceeded ? SEARCH_RESULTS_PAGE_SIZE : MAX_int32);
+        const int32 NumNewResults = SearchResults.Num() - FirstNewResult;
+
+        if (bIsDone)
+        {
+            ActiveSearches.Remove(Search);
+            Search->Complete();
+        }
+
+        if (Search->bStreamResults && (NumNewResults > 0 || bIsDone))
+        {
+            OnFindSessionsPageDelegates.Broadcast(Search->SearchSettings, FirstNewResult, NumNewResults, bIsDone);
+        }
+        if (bIsDone)
+        {
+            // Once for the search, followers were filled in by Complete() and listen on the same delegate
+            TriggerOnFindSessionsCompleteDelegates(Search->bSucceeded);
         }
     }
-    TriggerOnFindSessionsCompleteDelegates(success);
 }
 
 bool FOnlineSessionDrift::JoinSession(int32 PlayerNum, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
 {
     uint32 Return = E_FAIL;
+    auto JoinResult = EOnJoinSessionCompleteResult::UnknownError;
     auto Session = GetNamedSession(SessionName);
-    if (Session == nullptr)
+    if (Session == nullptr && IsSearchResultFull(DesiredSession))
+    {
+        // Travelling to a full server only to be turned away takes seconds
+        UE_LOG_ONLINE(Log, TEXT("Not joining session (%s), match %s is full"), *SessionName.ToString(), *DesiredSession.GetSessionIdStr());
+        JoinResult = EOnJoinSessionCompleteResult::SessionIsFull;
+    }
+    else if (Session == nullptr)
     {
         Session = AddNamedSession(SessionName, DesiredSession.Session);
         Session->HostingPlayerNum = PlayerNum;
 
-        auto SessionInfo = new FOnlineSessionInfoDrift{};
-        Session->SessionInfo = MakeShareable(SessionInfo);
         auto DesiredSessionInfo = static_cast<FOnlineSessionInfoDrift*>(DesiredSession.Session.SessionInfo.Get());
-        SessionInfo->Url = DesiredSessionInfo->Url;
-
-        Session->SessionSettings.bShouldAdvertise = false;
-
-        if (auto drift = DriftSubsystem->GetDrift())
+        auto SessionInfo = new FOnlineSessionInfoDrift{ *DesiredSessionInfo };
+        Session->SessionInfo = MakeShareable(SessionInfo);
+        if (SessionInfo->GetData().Ip == 0)
         {
-            drift->ResetMatchQueue();
+            if (auto PrewarmedAddress = ConnectionPrewarmer.FindAddress(SessionInfo->GetUrl()))
+            {
+                SessionInfo->SetResolvedAddress(*PrewarmedAddress);
+            }
         }
 
-        RegisterLocalPlayers(Session);
-        Return = ERROR_SUCCESS;
+        Session->SessionSettings.bShouldAdvertise = false;
+
+        MatchmakingStats.OnSessionJoined();
+        DriftSubsystem->QueueAsyncTask(new FOnlineAsyncTaskDriftJoinSession(DriftSubsystem, SessionName));
+        Return = ERROR_IO_PENDING;
     }
     else
     {
         UE_LOG_ONLINE(Warning, TEXT("Session (%s) already exists, can't join twice"), *SessionName.ToString());
+        JoinResult = EOnJoinSessionCompleteResult::AlreadyInSession;
     }
 
     if (Return != ERROR_IO_PENDING)
     {
         // Just trigger the delegate as having failed
-        TriggerOnJoinSessionCompleteDelegates(SessionName, Return == ERROR_SUCCESS ? EOnJoinSessionCompleteResult::Success : EOnJoinSessionCompleteResult::UnknownError);
+        TriggerOnJoinSessionCompleteDelegates(SessionName, Return == ERROR_SUCCESS ? EOnJoinSessionCompleteResult::Success : JoinResult);
     }
 
     return Return == ERROR_SUCCESS || Return == ERROR_IO_PENDING;
@@ -789,18 +1060,203 @@ bool FOnlineSessionDrift::SendSessionInviteToFriends(const FUniqueNetId& LocalUs
 
 bool FOnlineSessionDrift::PingSearchResults(const FOnlineSessionSearchResult& SearchResult)
 {
+    // The result is only known by reference, so find where it lives to be able to write the ping back
+    auto SearchSettings = LastSessionSearch.Pin();
+    if (SearchSettings.IsValid() && SearchResult.Session.SessionInfo.IsValid())
+    {
+        const int32 Index = SearchSettings->SearchResults.IndexOfByPredicate([&SearchResult](const FOnlineSessionSearchResult& Result)
+        {
+            return Result.Session.SessionInfo == SearchResult.Session.SessionInfo;
+        });
+        if (Index != INDEX_NONE)
+        {
+            return PingSearchResults(SearchSettings.ToSharedRef(), Index, 1);
+        }
+    }
+
+    UE_LOG_ONLINE(Warning, TEXT("Can only ping results of the most recent session search"));
     return false;
 }
 
-/** Get a resolved connection string from a session info */
-static bool GetConnectStringFromSessionInfo(TSharedPtr<FOnlineSessionInfoDrift>& SessionInfo, FString& ConnectInfo)
+bool FOnlineSessionDrift::PingSearchResults(const TSharedRef<FOnlineSessionSearch>& SearchSettings, int32 FirstResult, int32 NumResults)
+{
+    if (!LatencyProber.IsValid())
+    {
+        LatencyProber.Reset(new FDriftLatencyProber{});
+    }
+    if (!LatencyProber->IsEnabled())
+    {
+        UE_LOG_ONLINE(Warning, TEXT("Can't ping search results, there is no LatencyProbePort for servers to answer on"));
+        return false;
+    }
+
+    const auto& SearchResults = SearchSettings->SearchResults;
+    FirstResult = FMath::Clamp(FirstResult, 0, SearchResults.Num());
+    NumResults = NumResults == INDEX_NONE ? SearchResults.Num() - FirstResult : FMath::Clamp(NumResults, 0, SearchResults.Num() - FirstResult);
+    if (NumResults == 0)
+    {
+        OnSearchResultsPingedDelegates.Broadcast(SearchSettings);
+        return true;
+    }
+
+    TSharedPtr<int32> NumRemaining = MakeShareable(new int32{ NumResults });
+    TWeakPtr<FOnlineSessionSearch> WeakSearch = SearchSettings;
+    for (int32 Index = FirstResult; Index < FirstResult + NumResults; ++Index)
+    {
+        const auto& SessionInfo = SearchResults[Index].Session.SessionInfo;
+        const FOnlineSessionInfo* ExpectedInfo = SessionInfo.Get();
+        const FString Url = SessionInfo.IsValid() ? static_cast<const FOnlineSessionInfoDrift*>(ExpectedInfo)->GetUrl() : FString{};
+
+        LatencyProber->Probe(Url, FOnLatencyProbeComplete::CreateLambda([this, WeakSearch, Index, ExpectedInfo, NumRemaining](int32 PingInMs)
+        {
+            auto Search = WeakSearch.Pin();
+            if (!Search.IsValid())
+            {
+                return;
+            }
+            // Only write back if the result is still where it was when the probe started
+            auto& Results = Search->SearchResults;
+            if (Results.IsValidIndex(Index) && Results[Index].Session.SessionInfo.Get() == ExpectedInfo)
+            {
+                Results[Index].PingInMs = PingInMs;
+            }
+            if (--(*NumRemaining) == 0)
+            {
+                OnSearchResultsPingedDelegates.Broadcast(Search.ToSharedRef());
+            }
+        }));
+    }
+    return true;
+}
+
+void FOnlineSessionDrift::RankSearchResults(const TSharedRef<FOnlineSessionSearch>& SearchSettings, int32 K)
+{
+    const auto& SearchResults = SearchSettings->SearchResults;
+    K = K == INDEX_NONE ? SearchResults.Num() : FMath::Clamp(K, 0, SearchResults.Num());
+
+    TSharedRef<FDriftSearchResultRanker, ESPMode::ThreadSafe> Ranker = MakeShareable(new FDriftSearchResultRanker{ *SearchSettings, RecentMatches });
+
+    auto& Pending = PendingRankings[PendingRankings.AddDefaulted()];
+    Pending.Search = SearchSettings;
+    Pending.RankedInfos.Reserve(SearchResults.Num());
+    for (const auto& Result : SearchResults)
+    {
+        Pending.RankedInfos.Add(Result.Session.SessionInfo.Get());
+    }
+    Pending.Order = Async<TArray<int32>>(EAsyncExecution::ThreadPool, [Ranker, K]()
+    {
+        return Ranker->SelectTopK(K);
+    });
+}
+
+void FOnlineSessionDrift::TickRankings()
+{
+    TArray<TPair<TSharedRef<FOnlineSessionSearch>, int32>> Completed;
+    for (int32 Index = 0; Index < PendingRankings.Num();)
+    {
+        auto& Pending = PendingRankings[Index];
+        if (!Pending.Order.IsReady())
+        {
+            ++Index;
+            continue;
+        }
+
+        const TArray<int32> Order = Pending.Order.Get();
+        auto Search = Pending.Search.Pin();
+        if (Search.IsValid())
+        {
+            auto& SearchResults = Search->SearchResults;
+            bool bUnchanged = SearchResults.Num() == Pending.RankedInfos.Num();
+            for (int32 ResultIndex = 0; bUnchanged && ResultIndex < SearchResults.Num(); ++ResultIndex)
+            {
+                bUnchanged = SearchResults[ResultIndex].Session.SessionInfo.Get() == Pending.RankedInfos[ResultIndex];
+            }
+
+            if (bUnchanged)
+            {
+                // The ranked ones first, best first, everything else after in the order it was
+                TArray<bool> IsRanked;
+                IsRanked.SetNumZeroed(SearchResults.Num());
+                TArray<FOnlineSessionSearchResult> Reordered;
+                Reordered.Reserve(SearchResults.Num());
+                for (const int32 ResultIndex : Order)
+                {
+                    IsRanked[ResultIndex] = true;
+                    Reordered.Add(MoveTemp(SearchResults[ResultIndex]));
+                }
+                for (int32 ResultIndex = 0; ResultIndex < SearchResults.Num(); ++ResultIndex)
+                {
+                    if (!IsRanked[ResultIndex])
+                    {
+                        Reordered.Add(MoveTemp(SearchResults[ResultIndex]));
+                    }
+                }
+                SearchResults = MoveTemp(Reordered);
+            }
+            Completed.Emplace(Search.ToSharedRef(), bUnchanged ? Order.Num() : 0);
+        }
+        PendingRankings.RemoveAt(Index);
+    }
+
+    // Listeners may well rank again
+    for (const auto& Ranked : Completed)
+    {
+        OnSearchResultsRankedDelegates.Broadcast(Ranked.Key, Ranked.Value);
+    }
+}
+
+bool FOnlineSessionDrift::QuickJoin(int32 PlayerNum, FName SessionName, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnQuickJoinCompleteDelegate& CompletionDelegate)
+{
+    const bool bAlreadyJoining = QuickJoins.ContainsByPredicate([SessionName](const TUniquePtr<FDriftQuickJoin>& Existing)
+    {
+        return !Existing->IsDone() && Existing->GetSessionName() == SessionName;
+    });
+    auto NewQuickJoin = new FDriftQuickJoin{ *this, PlayerNum, SessionName, SearchSettings, CompletionDelegate };
+    QuickJoins.Emplace(NewQuickJoin);
+    if (bAlreadyJoining || GetNamedSession(SessionName) != nullptr)
+    {
+        UE_LOG_ONLINE(Warning, TEXT("Session (%s) already exists or is being quick joined, can't quick join it"), *SessionName.ToString());
+        // Never from within the call, like every other outcome
+        NewQuickJoin->Fail(EOnJoinSessionCompleteResult::AlreadyInSession);
+        return false;
+    }
+
+    // A failed start completes on the next tick like everything else
+    return NewQuickJoin->Start();
+}
+
+void FOnlineSessionDrift::TickQuickJoins()
+{
+    TArray<TUniquePtr<FDriftQuickJoin>> Completed;
+    for (int32 Index = QuickJoins.Num() - 1; Index >= 0; --Index)
+    {
+        if (QuickJoins[Index]->Tick())
+        {
+            Completed.Add(MoveTemp(QuickJoins[Index]));
+            QuickJoins.RemoveAt(Index);
+        }
+    }
+
+    // Listeners may well quick join again
+    for (int32 Index = Completed.Num() - 1; Index >= 0; --Index)
+    {
+        Completed[Index]->TriggerDelegates();
+    }
+}
+
+/** Get a resolved connection string from a session info, using the prewarmed address when there is one */
+static bool GetConnectStringFromSessionInfo(TSharedPtr<FOnlineSessionInfoDrift>& SessionInfo, const FDriftConnectionPrewarmer& Prewarmer, FString& ConnectInfo)
 {
     bool bSuccess = false;
     if (SessionInfo.IsValid())
     {
-        if (!SessionInfo->Url.IsEmpty())
+        if (SessionInfo->IsValid())
         {
-            ConnectInfo = SessionInfo->Url;
+            // An address in the session info wins, otherwise the host may have been resolved ahead of time
+            if (SessionInfo->GetData().Ip != 0 || !Prewarmer.GetResolvedUrl(SessionInfo->GetUrl(), ConnectInfo))
+            {
+                ConnectInfo = SessionInfo->GetConnectString();
+            }
             bSuccess = true;
         }
     }
@@ -816,7 +1272,7 @@ bool FOnlineSessionDrift::GetResolvedConnectString(FName SessionName, FString& C
     if (Session != nullptr)
     {
         TSharedPtr<FOnlineSessionInfoDrift> SessionInfo = StaticCastSharedPtr<FOnlineSessionInfoDrift>(Session->SessionInfo);
-        bSuccess = GetConnectStringFromSessionInfo(SessionInfo, ConnectInfo);
+        bSuccess = GetConnectStringFromSessionInfo(SessionInfo, ConnectionPrewarmer, ConnectInfo);
         if (!bSuccess)
         {
             UE_LOG_ONLINE(Warning, TEXT("Invalid session info for session %s in GetResolvedConnectString()"), *SessionName.ToString());
@@ -838,7 +1294,7 @@ bool FOnlineSessionDrift::GetResolvedConnectString(const class FOnlineSessionSea
     if (SearchResult.Session.SessionInfo.IsValid())
     {
         TSharedPtr<FOnlineSessionInfoDrift> SessionInfo = StaticCastSharedPtr<FOnlineSessionInfoDrift>(SearchResult.Session.SessionInfo);
-        bSuccess = GetConnectStringFromSessionInfo(SessionInfo, ConnectInfo);
+        bSuccess = GetConnectStringFromSessionInfo(SessionInfo, ConnectionPrewarmer, ConnectInfo);
     }
     
     if (!bSuccess || ConnectInfo.IsEmpty())
@@ -917,37 +1373,20 @@ bool FOnlineSessionDrift::RegisterPlayer(FName SessionName, const FUniqueNetId&
 bool FOnlineSessionDrift::RegisterPlayers(FName SessionName, const TArray<TSharedRef<const FUniqueNetId>>& Players, bool bWasInvited)
 {
     bool bSuccess = false;
-    FNamedOnlineSession* Session = GetNamedSession(SessionName);
+    FDriftRegisteredPlayerIndex* PlayerIndex = nullptr;
+    FNamedOnlineSession* Session = Sessions.Find(SessionName, PlayerIndex);
     if (Session)
     {
         bSuccess = true;
 
+        TArray<DriftID> AddedPlayers;
         for (const auto& PlayerId : Players)
         {
-            FUniqueNetIdMatcher PlayerMatch(*PlayerId);
-            if (Session->RegisteredPlayers.IndexOfByPredicate(PlayerMatch) == INDEX_NONE)
+            if (PlayerIndex->Find(*Session, *PlayerId) == INDEX_NONE)
             {
-                Session->RegisteredPlayers.Add(PlayerId);
+                PlayerIndex->Add(*Session, PlayerId);
                 RegisterVoice(*PlayerId);
-
-                if (IsRunningDedicatedServer())
-                {
-                    if (auto Drift = DriftSubsystem->GetDrift())
-                    {
-                        Drift->AddPlayerToMatch(FUniqueNetIdDrift{ *PlayerId }.GetId(), 0, FDriftPlayerAddedDelegate::CreateLambda([this, SessionName, Session, Players](bool success)
-                        {
-                            if (success)
-                            {
-
-                            }
-                            else
-                            {
-                                UE_LOG_ONLINE(Warning, TEXT("Failed to register player with Drift session"));
-                            }
-                            TriggerOnRegisterPlayersCompleteDelegates(SessionName, Players, success);
-                        }));
-                    }
-                }
+                AddedPlayers.Add(FUniqueNetIdDrift{ *PlayerId }.GetId());
 
                 if (Session->NumOpenPublicConnections > 0)
                 {
@@ -957,13 +1396,25 @@ bool FOnlineSessionDrift::RegisterPlayers(FName SessionName, const TArray<TShare
                 {
                     Session->NumOpenPrivateConnections--;
                 }
-                return bSuccess;
             }
             else
             {
                 RegisterVoice(*PlayerId);
                 UE_LOG_ONLINE(Log, TEXT("Player %s already registered in session %s"), *PlayerId->ToDebugString(), *SessionName.ToString());
-            }            
+            }
+        }
+
+        if (AddedPlayers.Num() > 0 && IsRunningDedicatedServer() && DriftSubsystem->GetDrift())
+        {
+            PlayerRegistrations.Queue(AddedPlayers, true, [this, SessionName, Players](bool success)
+            {
+                if (!success)
+                {
+                    UE_LOG_ONLINE(Warning, TEXT("Failed to register players with Drift session"));
+                }
+                TriggerOnRegisterPlayersCompleteDelegates(SessionName, Players, success);
+            });
+            return bSuccess;
         }
     }
     else
@@ -986,36 +1437,19 @@ bool FOnlineSessionDrift::UnregisterPlayers(FName SessionName, const TArray<TSha
 {
     bool bSuccess = true;
 
-    FNamedOnlineSession* Session = GetNamedSession(SessionName);
+    FDriftRegisteredPlayerIndex* PlayerIndex = nullptr;
+    FNamedOnlineSession* Session = Sessions.Find(SessionName, PlayerIndex);
     if (Session)
     {
+        TArray<DriftID> RemovedPlayers;
         for (const auto& PlayerId : Players)
         {
-            FUniqueNetIdMatcher PlayerMatch(*PlayerId);
-            int32 RegistrantIndex = Session->RegisteredPlayers.IndexOfByPredicate(PlayerMatch);
+            int32 RegistrantIndex = PlayerIndex->Find(*Session, *PlayerId);
             if (RegistrantIndex != INDEX_NONE)
             {
-                Session->RegisteredPlayers.RemoveAtSwap(RegistrantIndex);
+                PlayerIndex->RemoveAt(*Session, RegistrantIndex);
                 UnregisterVoice(*PlayerId);
-
-                if (IsRunningDedicatedServer())
-                {
-                    if (auto Drift = DriftSubsystem->GetDrift())
-                    {
-                        Drift->RemovePlayerFromMatch(FUniqueNetIdDrift{ *PlayerId }.GetId(), FDriftPlayerRemovedDelegate::CreateLambda([this, SessionName, Session, Players](bool success)
-                        {
-                            if (success)
-                            {
-
-                            }
-                            else
-                            {
-                                UE_LOG_ONLINE(Warning, TEXT("Failed to unregister player with Drift session"));
-                            }
-                            TriggerOnUnregisterPlayersCompleteDelegates(SessionName, Players, success);
-                        }));
-                    }
-                }
+                RemovedPlayers.Add(FUniqueNetIdDrift{ *PlayerId }.GetId());
 
                 if (Session->NumOpenPublicConnections < Session->SessionSettings.NumPublicConnections)
                 {
@@ -1025,13 +1459,25 @@ bool FOnlineSessionDrift::UnregisterPlayers(FName SessionName, const TArray<TSha
                 {
                     Session->NumOpenPrivateConnections++;
                 }
-                return bSuccess;
             }
             else
             {
                 UE_LOG_ONLINE(Warning, TEXT("Player %s is not part of session (%s)"), *PlayerId->ToDebugString(), *SessionName.ToString());
             }
         }
+
+        if (RemovedPlayers.Num() > 0 && IsRunningDedicatedServer() && DriftSubsystem->GetDrift())
+        {
+            PlayerRegistrations.Queue(RemovedPlayers, false, [this, SessionName, Players](bool success)
+            {
+                if (!success)
+                {
+                    UE_LOG_ONLINE(Warning, TEXT("Failed to unregister players with Drift session"));
+                }
+                TriggerOnUnregisterPlayersCompleteDelegates(SessionName, Players, success);
+            });
+            return bSuccess;
+        }
     }
     else
     {
@@ -1043,6 +1489,11 @@ bool FOnlineSessionDrift::UnregisterPlayers(FName SessionName, const TArray<TSha
     return bSuccess;
 }
 
+void FOnlineSessionDrift::Shutdown()
+{
+    PlayerRegistrations.Shutdown();
+}
+
 void FOnlineSessionDrift::Tick(float DeltaTime)
 {
     SCOPE_CYCLE_COUNTER(STAT_Session_Interface);
@@ -1051,24 +1502,94 @@ void FOnlineSessionDrift::Tick(float DeltaTime)
     {
         CurrentSearch->Tick(DeltaTime);
     }
+
+    PlayerRegistrations.Tick(DeltaTime);
+
+    if (LatencyProber.IsValid())
+    {
+        LatencyProber->Tick(DeltaTime);
+    }
+
+    LatencyEchoResponder.Tick(DeltaTime);
+
+    ConnectionPrewarmer.Tick(DeltaTime);
+
+    if (PendingActiveMatches.IsValid() && FPlatformTime::Seconds() - PendingActiveMatchesTime > ActiveMatchesTimeout)
+    {
+        UE_LOG_ONLINE(Warning, TEXT("No match list from Drift after %.1f seconds"), ActiveMatchesTimeout);
+        CompleteActiveMatches(false);
+    }
+
+    if (PendingRankings.Num() > 0)
+    {
+        TickRankings();
+    }
+
+    if (ActiveSearches.Num() > 0)
+    {
+        TickSearches();
+    }
+
+    // Last, so stages that completed during this tick are picked up right away
+    if (QuickJoins.Num() > 0)
+    {
+        TickQuickJoins();
+    }
 }
 
 int32 FOnlineSessionDrift::GetNumSessions()
 {
-    FScopeLock ScopeLock(&SessionLock);
     return Sessions.Num();
 }
 
 void FOnlineSessionDrift::DumpSessionState()
 {
-    FScopeLock ScopeLock(&SessionLock);
+    // Sessions are only removed on the game thread, so they outlive the lock for as long as we're here
+    TArray<const FNamedOnlineSession*> ToDump;
+    Sessions.ForEach([&ToDump](const FNamedOnlineSession& Session)
+    {
+        ToDump.Add(&Session);
+    });
 
-    for (int32 SessionIdx=0; SessionIdx < Sessions.Num(); SessionIdx++)
+    for (const auto Session : ToDump)
     {
-        DumpNamedSession(&Sessions[SessionIdx]);
+        DumpNamedSession(Session);
     }
 }
 
+void FOnlineSessionDrift::CaptureSessionState(FDriftSessionStateSnapshot& OutSnapshot) const
+{
+    OutSnapshot.CaptureTime = FPlatformTime::Seconds();
+    OutSnapshot.Sessions.Reset();
+
+    Sessions.ForEach([this, &OutSnapshot](const FNamedOnlineSession& Session)
+    {
+        auto& Captured = OutSnapshot.Sessions[OutSnapshot.Sessions.AddDefaulted()];
+        Captured.Name = Session.SessionName;
+        Captured.State = Session.SessionState;
+        if (const auto SessionInfo = static_cast<const FOnlineSessionInfoDrift*>(Session.SessionInfo.Get()))
+        {
+            Captured.SessionId = SessionInfo->ToString();
+            Captured.ConnectString = SessionInfo->GetConnectString();
+        }
+        Captured.NumPublicConnections = Session.SessionSettings.NumPublicConnections;
+        Captured.NumOpenPublicConnections = Session.NumOpenPublicConnections;
+        Captured.NumPrivateConnections = Session.SessionSettings.NumPrivateConnections;
+        Captured.NumOpenPrivateConnections = Session.NumOpenPrivateConnections;
+        Captured.RegisteredPlayers = Session.RegisteredPlayers;
+    });
+
+    OutSnapshot.NumPendingSessionTasks = DriftSubsystem->NumPendingSessionTasks.GetValue();
+    OutSnapshot.NumQueuedPlayerUpdates = PlayerRegistrations.NumQueued();
+    OutSnapshot.NumActiveSearches = ActiveSearches.Num();
+    OutSnapshot.NumPendingSessionLookups = PendingSessionLookups.Num();
+    OutSnapshot.NumPendingRankings = PendingRankings.Num();
+    OutSnapshot.NumQuickJoins = QuickJoins.Num();
+    OutSnapshot.bFetchingMatchList = PendingActiveMatches.IsValid() && !bPendingActiveMatchesAbandoned;
+    OutSnapshot.bInMatchQueue = CurrentSearch.IsValid();
+    OutSnapshot.ReportedServerStatus = ReportedServerStatus;
+}
+
 void FOnlineSessionDrift::RegisterLocalPlayer(const FUniqueNetId& PlayerId, FName SessionName, const FOnRegisterLocalPlayerCompleteDelegate& Delegate)
 {
     Delegate.ExecuteIfBound(PlayerId, EOnJoinSessionCompleteResult::Success);
@@ -1080,60 +1601,104 @@ void FOnlineSessionDrift::UnregisterLocalPlayer(const FUniqueNetId& PlayerId, FN
 }
 
 
-FMatchQueueSearch::FMatchQueueSearch(FOnlineSubsystemDrift* subsystem)
+FMatchQueueSearch::FMatchQueueSearch(FOnlineSubsystemDrift* subsystem, FDriftMatchmakingStats& stats)
     : DriftSubsystem(subsystem)
+    , matchmakingStats(stats)
 {
+    delay = pollScheduler.Reset();
 }
 
 void FMatchQueueSearch::Tick(float deltaTime)
 {
+    pollScheduler.Tick(deltaTime);
+
+    if (receivingPushes)
+    {
+        timeSinceLastPush += deltaTime;
+        if (timeSinceLastPush < PUSH_TIMEOUT)
+        {
+            return;
+        }
+
+        UE_LOG_ONLINE(Log, TEXT("No match queue status pushed for %.1f seconds, falling back to polling"), timeSinceLastPush);
+        receivingPushes = false;
+        delay = 0.0f;
+    }
+
     if (delay > 0.0f)
     {
         delay -= deltaTime;
     }
 
-    if (queueStatus != TEXT("matched") && delay < 0.0f && !isPolling)
+    if (queueStatus != TEXT("matched") && delay <= 0.0f && !isPolling)
     {
         PollQueue();
     }
 }
 
+void FMatchQueueSearch::OnStatusPushed(const FMatchQueueStatus& status)
+{
+    receivingPushes = true;
+    timeSinceLastPush = 0.0f;
+    ++statusVersion;
+    ApplyStatus(status, true);
+}
+
 void FMatchQueueSearch::PollQueue()
 {
     if (auto drift = DriftSubsystem->GetDrift())
     {
         isPolling = true;
-        drift->PollMatchQueue(FDriftPolledMatchQueueDelegate::CreateSP(this, &FMatchQueueSearch::OnPollQueueComplete));
+        pollScheduler.OnPollSent();
+        pollSentTime = FPlatformTime::Seconds();
+        drift->PollMatchQueue(FDriftPolledMatchQueueDelegate::CreateSP(this, &FMatchQueueSearch::OnPollQueueComplete, statusVersion));
     }
 }
 
-void FMatchQueueSearch::OnPollQueueComplete(bool success, const FMatchQueueStatus& status)
+void FMatchQueueSearch::OnPollQueueComplete(bool success, const FMatchQueueStatus& status, int32 pollStatusVersion)
 {
     isPolling = false;
-    delay = POLL_FREQUENCY;
     if (success)
     {
-        FName oldStatus = queueStatus;
-        if (status.status == FName(TEXT("waiting")))
-        {
-            currentMatch = FActiveMatch{};
-        }
-        else if (status.status == FName(TEXT("matched")))
-        {
-            currentMatch = status.match;
-        }
-        else if (status.status == FName(TEXT("timedout")))
-        {
-            currentMatch = FActiveMatch{};
-        }
-        else if (status.status == FName(TEXT("usurped")))
-        {
-            currentMatch = FActiveMatch{};
-        }
+        matchmakingStats.OnPollComplete(static_cast<float>(FPlatformTime::Seconds() - pollSentTime));
+    }
+    if (success && pollStatusVersion == statusVersion)
+    {
+        ApplyStatus(status, false);
+    }
+    delay = pollScheduler.OnPollComplete(success);
+}
+
+void FMatchQueueSearch::ApplyStatus(const FMatchQueueStatus& status, bool wasPushed)
+{
+    FName oldStatus = queueStatus;
+    if (status.status == FName(TEXT("waiting")))
+    {
+        currentMatch = FActiveMatch{};
+    }
+    else if (status.status == FName(TEXT("matched")))
+    {
+        currentMatch = status.match;
+    }
+    else if (status.status == FName(TEXT("timedout")))
+    {
+        currentMatch = FActiveMatch{};
+    }
+    else if (status.status == FName(TEXT("usurped")))
+    {
+        currentMatch = FActiveMatch{};
+    }
+    queueStatus = status.status;
 
-        if (oldStatus != status.status)
+    if (oldStatus != status.status)
+    {
+        if (status.status == FName(TEXT("matched")))
         {
-            onMatchQueueStatusChanged.Broadcast(status.status);
+            pollScheduler.OnMatchDetected(wasPushed);
+            const auto& stats = pollScheduler.GetStats();
+            UE_LOG_ONLINE(Log, TEXT("Matched after %.1f seconds in queue, %d polls (%d failed), detected within %.2f seconds"),
+                stats.TimeInQueue, stats.NumPolls, stats.NumFailedPolls, stats.MatchDetectionWindow);
         }
+        onMatchQueueStatusChanged.Broadcast(status.status);
     }
 }
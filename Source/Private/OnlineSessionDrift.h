@@ -5,6 +5,20 @@
 #include "OnlineSessionInterface.h"
 #include "OnlineSessionSettings.h"
 #include "OnlineSubsystemDriftTypes.h"
+#include "OnlineSessionInterfaceDrift.h"
+#include "DriftSessionRegistry.h"
+#include "DriftMatchQueuePollScheduler.h"
+#include "DriftMatchQuery.h"
+#include "DriftLatencyProber.h"
+#include "DriftMatchIndex.h"
+#include "DriftPlayerRegistrationBatcher.h"
+#include "DriftMatchQueueTicket.h"
+#include "DriftMatchmakingStats.h"
+#include "DriftConnectionPrewarmer.h"
+#include "DriftSessionSearch.h"
+#include "DriftSearchResultRanker.h"
+#include "DriftQuickJoin.h"
+#include "DriftSessionStateSnapshot.h"
 #include "OnlineSubsystemDriftPackage.h"
 
 #include "DriftAPI.h"
@@ -16,24 +30,51 @@ DECLARE_MULTICAST_DELEGATE_OneParam(FMatchQueueStatusChangedDelegate, FName);
 class FMatchQueueSearch : public TSharedFromThis<FMatchQueueSearch>
 {
 public:
-    FMatchQueueSearch(FOnlineSubsystemDrift* subsystem);
+    /**
+     * @param subsystem owning subsystem
+     * @param stats receives the round trip of every poll, must outlive the search
+     */
+    FMatchQueueSearch(FOnlineSubsystemDrift* subsystem, FDriftMatchmakingStats& stats);
     void Tick(float deltaTime);
 
+    /**
+     * Apply a queue status pushed by the backend.
+     * Polling is suspended for as long as pushes keep arriving, and resumes as a fallback if they stop.
+     */
+    void OnStatusPushed(const FMatchQueueStatus& status);
+
     FMatchQueueStatusChangedDelegate& OnMatchQueueStatusChanged() { return onMatchQueueStatusChanged;  }
 
     const FActiveMatch& GetCurrentMatch() { return currentMatch; }
 
+    bool IsReceivingPushes() const { return receivingPushes; }
+
+    /** Wait at least this long before the next poll, as instructed by the server */
+    void SetRetryAfterHint(float seconds) { pollScheduler.SetRetryAfter(seconds); }
+
+    const FMatchQueuePollStats& GetPollStats() const { return pollScheduler.GetStats(); }
+
 private:
     void PollQueue();
-    void OnPollQueueComplete(bool success, const FMatchQueueStatus& status);
+    void OnPollQueueComplete(bool success, const FMatchQueueStatus& status, int32 pollStatusVersion);
+    void ApplyStatus(const FMatchQueueStatus& status, bool wasPushed);
 
     FMatchQueueStatusChangedDelegate onMatchQueueStatusChanged;
 
-    const float POLL_FREQUENCY{ 3.0f };
+    /** Fall back to polling if no status has been pushed for this long */
+    const float PUSH_TIMEOUT{ 30.0f };
 
+    FMatchQueuePollScheduler pollScheduler;
     bool isPolling{ false };
-    float delay{ POLL_FREQUENCY };
+    float delay{ 0.0f };
+    bool receivingPushes{ false };
+    float timeSinceLastPush{ 0.0f };
+    /** Bumped on every pushed status, so a poll that was in flight when it arrived can't overwrite it */
+    int32 statusVersion{ 0 };
+    /** FPlatformTime::Seconds() when the poll in flight was sent */
+    double pollSentTime{ 0.0 };
     FOnlineSubsystemDrift* DriftSubsystem;
+    FDriftMatchmakingStats& matchmakingStats;
     FName queueStatus;
     FActiveMatch currentMatch;
 };
@@ -43,7 +84,7 @@ private:
  * Session services are defined as anything related managing a session 
  * and its state within a platform service
  */
-class FOnlineSessionDrift : public IOnlineSession
+class FOnlineSessionDrift : public IOnlineSessionDrift
 {
 private:
 
@@ -53,34 +94,132 @@ private:
     /** Hidden on purpose */
     FOnlineSessionDrift() :
         DriftSubsystem(nullptr),
-        CurrentSessionSearch(nullptr)
+        CurrentSessionSearch(nullptr),
+        PlayerRegistrations(nullptr)
     {}
 
 PACKAGE_SCOPE:
 
-    /** Critical sections for thread safe operation of session lists */
-    mutable FCriticalSection SessionLock;
-
-    /** Current session settings */
-    TArray<FNamedOnlineSession> Sessions;
+    /** Current sessions, keyed by name, safe to read from any thread */
+    FDriftSessionRegistry Sessions;
 
-    /** Current search object */
+    /** Search passed to StartMatchmaking, while matchmaking */
     TSharedPtr<FOnlineSessionSearch> CurrentSessionSearch;
     FName CurrentSessionSearchName;
-    TSharedPtr<FMatchesSearch> DriftSearch;
+
+    /** FindSessions calls in progress, in the order they were made, followers not included */
+    TArray<TSharedRef<FDriftSessionSearch>> ActiveSearches;
+    /** Matches turned into search results per tick when streaming */
+    const int32 SEARCH_RESULTS_PAGE_SIZE{ 50 };
+
+    FOnFindSessionsPageDelegate OnFindSessionsPageDelegates;
+
+    /** Most recent search passed to FindSessions, results of it can be pinged individually */
+    TWeakPtr<FOnlineSessionSearch> LastSessionSearch;
+    /** Created on the first ping */
+    TUniquePtr<FDriftLatencyProber> LatencyProber;
+    FOnSearchResultsPingedDelegate OnSearchResultsPingedDelegates;
+
+    /** Answers the latency probes of clients, started with the first session on a dedicated server */
+    FDriftLatencyEchoResponder LatencyEchoResponder;
 
     TSharedPtr<FMatchQueueSearch> CurrentSearch;
+    /** What the group in the match queue asked for */
+    FDriftMatchQueueTicket CurrentMatchQueueTicket;
+    /** Bumped by CancelMatchmaking, so a join still retrying on the online thread gives up */
+    FThreadSafeCounter MatchQueueGeneration;
+
+    /** Latency of the matchmaking phases, see MATCHQUEUE STATS */
+    FDriftMatchmakingStats MatchmakingStats;
+
+    /** Resolves matched servers while the game is still on its way to JoinSession */
+    FDriftConnectionPrewarmer ConnectionPrewarmer;
+
+    struct FPendingRanking
+    {
+        TWeakPtr<FOnlineSessionSearch> Search;
+        /** The session info of every result when ranking started, the order only applies if they're unchanged */
+        TArray<const FOnlineSessionInfo*> RankedInfos;
+        /** Best results first, computed on the thread pool */
+        TFuture<TArray<int32>> Order;
+    };
+    /** RankSearchResults calls waiting for their order */
+    TArray<FPendingRanking> PendingRankings;
+    FOnSearchResultsRankedDelegate OnSearchResultsRankedDelegates;
+
+    /** Reorder the searches whose ranking has completed */
+    void TickRankings();
+
+    /** Match list request in flight, shared by everyone who needs a fresh list */
+    TSharedPtr<FMatchesSearch> PendingActiveMatches;
+    /** FPlatformTime::Seconds() when PendingActiveMatches was requested */
+    double PendingActiveMatchesTime{ 0.0 };
+    /** Seconds before a match list request counts as failed, SessionRequestTimeout */
+    float ActiveMatchesTimeout{ 10.0f };
+    /**
+     * Everyone waiting for PendingActiveMatches cancelled
+     * Drift can't abort the request, but its response is dropped instead of indexed and delivered
+     */
+    bool bPendingActiveMatchesAbandoned{ false };
+
+    /** Recently seen matches by match id, for FindSessionById and fresh player counts */
+    FDriftMatchIndex RecentMatches;
+
+    /** The match the match queue placed us in, it counts us among its players before we join */
+    int32 MatchmadeMatchId{ 0 };
+
+    /** Bring the open slots of LastSessionSearch's results up to date with RecentMatches */
+    void RefreshOpenSlots();
+
+    /** @return true if the freshest player count says there's no room in the match of a search result */
+    bool IsSearchResultFull(const FOnlineSessionSearchResult& SearchResult) const;
+
+    struct FPendingSessionLookup
+    {
+        int32 MatchId;
+        FOnSingleSessionResultCompleteDelegate CompletionDelegate;
+    };
+    /** FindSessionById calls waiting for PendingActiveMatches */
+    TArray<FPendingSessionLookup> PendingSessionLookups;
 
-    FDelegateHandle onMatchAddedDelegateHandle;
     FDelegateHandle onGotActiveMatchesHandle;
 
+    /** Last successful GetActiveMatches result, shared by all searches while it's fresh */
+    TSharedPtr<FMatchesSearch> CachedActiveMatches;
+    /** FPlatformTime::Seconds() when CachedActiveMatches arrived */
+    double CachedActiveMatchesTime{ 0.0 };
+    /** Seconds a match list is reused before it's fetched again, 0 disables the cache */
+    float ActiveMatchesCacheTTL{ 5.0f };
+
+    /** Match player updates waiting to be sent to Drift, dedicated server only */
+    FDriftPlayerRegistrationBatcher PlayerRegistrations;
+
+    /** Last server status Drift acknowledged, dedicated server only */
+    FName ReportedServerStatus;
+
+    /** QuickJoin calls in progress, they unbind from the delegates above when they go */
+    TArray<TUniquePtr<FDriftQuickJoin>> QuickJoins;
+
+    /** Advance the quick joins and complete those that are done */
+    void TickQuickJoins();
+
     FOnlineSessionDrift(class FOnlineSubsystemDrift* InSubsystem) :
         DriftSubsystem(InSubsystem),
-        CurrentSessionSearch(nullptr)
-    {}
+        CurrentSessionSearch(nullptr),
+        PlayerRegistrations(InSubsystem)
+    {
+        GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("ActiveMatchesCacheTTL"), ActiveMatchesCacheTTL, GEngineIni);
+        GConfig->GetFloat(DRIFT_CONFIG_SECTION, TEXT("SessionRequestTimeout"), ActiveMatchesTimeout, GEngineIni);
+    }
+
+    /** Drop the cached match list, the next search goes to the backend */
+    void InvalidateActiveMatchesCache();
 
     void Tick(float DeltaTime);
 
+    /** Send what is still queued for Drift while the subsystem can, before it goes away */
+    void Shutdown();
+
     // IOnlineSession
     class FNamedOnlineSession* AddNamedSession(FName SessionName, const FOnlineSessionSettings& SessionSettings) override;
     class FNamedOnlineSession* AddNamedSession(FName SessionName, const FOnlineSession& Session) override;
@@ -107,13 +246,71 @@ PACKAGE_SCOPE:
     void RegisterLocalPlayers(class FNamedOnlineSession* Session);
 
     void OnJoinedMatchQueue(bool success, const FMatchQueueStatus& status);
+    void OnLeftMatchQueue(FName SessionName, bool success);
     void OnMatchSearchStatusChanged(FName status);
-    void OnMatchAdded(bool success);
+
+    /**
+     * Entry point for match queue status changes pushed by the backend
+     *
+     * @param status the new queue status, including the match when matched
+     */
+    void OnMatchQueueStatusPushed(const FMatchQueueStatus& status);
+
+    /**
+     * Console commands for the match queue, MATCHQUEUE PUSH <status> [url] stands in for a pushing backend,
+     * MATCHQUEUE STATS [RESET] dumps, or clears, the matchmaking latency histograms
+     */
+    bool HandleMatchQueueExecCommands(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar);
+
+    /** Console command for ops tooling, SESSIONSTATE logs CaptureSessionState() as JSON */
+    bool HandleSessionStateExecCommands(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar);
+
+    /** Console commands for search results, SEARCHRESULTS BENCH [count] times building results for fake matches */
+    bool HandleSearchResultsExecCommands(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar);
+    /**
+     * Request the active match list, unless a request is already in flight
+     *
+     * @return false if the Drift API isn't available
+     */
+    bool FetchActiveMatches();
+
+    /**
+     * Drift's match list completion, which fires for every GetActiveMatches request, not just ours
+     * A success is ours once the marker it was sent with is gone or joined by matches,
+     * a failure doesn't say whose it was and fails ours
+     */
     void OnGotActiveMatches(bool success);
 
+    /** Hand PendingActiveMatches, less the marker, to everyone waiting for it, an empty list on failure */
+    void CompleteActiveMatches(bool success);
+
+    /** Complete a FindSessionById from the match index, returns false if the match isn't indexed */
+    bool TryCompleteSessionLookup(int32 MatchId, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate);
+
+    /** Cancel one search, returns false if it isn't in progress */
+    bool CancelSearch(const FOnlineSessionSearch& Search);
+
+    /** Abandon the match list request in flight if nobody is waiting for it any more */
+    void ReleaseActiveMatches();
+
+    /**
+     * Build results for every search that has its match list, page by page for streaming searches,
+     * and complete those that are done
+     */
+    void TickSearches();
+
 public:
 
-    virtual ~FOnlineSessionDrift() {}
+    virtual ~FOnlineSessionDrift();
+
+    // IOnlineSessionDrift
+    virtual bool CancelFindSessions(const TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+    virtual FOnFindSessionsPageDelegate& OnFindSessionsPage() override { return OnFindSessionsPageDelegates; }
+    virtual bool PingSearchResults(const TSharedRef<FOnlineSessionSearch>& SearchSettings, int32 FirstResult = 0, int32 NumResults = INDEX_NONE) override;
+    virtual FOnSearchResultsPingedDelegate& OnSearchResultsPinged() override { return OnSearchResultsPingedDelegates; }
+    virtual void RankSearchResults(const TSharedRef<FOnlineSessionSearch>& SearchSettings, int32 K = INDEX_NONE) override;
+    virtual FOnSearchResultsRankedDelegate& OnSearchResultsRanked() override { return OnSearchResultsRankedDelegates; }
+    virtual bool QuickJoin(int32 PlayerNum, FName SessionName, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnQuickJoinCompleteDelegate& CompletionDelegate) override;
 
     virtual FNamedOnlineSession* GetNamedSession(FName SessionName) override;
     virtual void RemoveNamedSession(FName SessionName) override;
@@ -156,6 +353,9 @@ public:
     virtual void UnregisterLocalPlayer(const FUniqueNetId& PlayerId, FName SessionName, const FOnUnregisterLocalPlayerCompleteDelegate& Delegate) override;
     virtual int32 GetNumSessions() override;
     virtual void DumpSessionState() override;
+
+    /** Copy the state of every session and of the work waiting on Drift, see FDriftSessionStateSnapshot */
+    void CaptureSessionState(FDriftSessionStateSnapshot& OutSnapshot) const;
 };
 
 typedef TSharedPtr<FOnlineSessionDrift, ESPMode::ThreadSafe> FOnlineSessionDriftPtr;
@@ -19,6 +19,7 @@
  */
 #include "OnlineIdentityDrift.h"
 #include "VoiceInterfaceDrift.h"
+#include "DriftServerHeartbeat.h"
 /*
 #include "OnlineAchievementsInterfaceDrift.h"
 */
@@ -169,6 +170,11 @@ bool FOnlineSubsystemDrift::Tick(float DeltaTime)
         VoiceInterface->Tick(DeltaTime);
     }
 
+    if (ServerHeartbeat)
+    {
+        ServerHeartbeat->Tick(DeltaTime);
+    }
+
     return true;
 }
 
@@ -190,6 +196,11 @@ bool FOnlineSubsystemDrift::Init()
         IdentityInterface = MakeShareable(new FOnlineIdentityDrift(this));
 //        AchievementsInterface = MakeShareable(new FOnlineAchievementsDrift(this));
         VoiceInterface = MakeShareable(new FOnlineVoiceDrift(this));
+
+        if (IsRunningDedicatedServer())
+        {
+            ServerHeartbeat = new FDriftServerHeartbeat(this);
+        }
     }
     else
     {
@@ -203,8 +214,19 @@ bool FOnlineSubsystemDrift::Shutdown()
 {
     UE_LOG_ONLINE(Display, TEXT("FOnlineSubsystemDrift::Shutdown()"));
 
+    if (SessionInterface.IsValid())
+    {
+        SessionInterface->Shutdown();
+    }
+
     FOnlineSubsystemImpl::Shutdown();
 
+    if (ServerHeartbeat)
+    {
+        delete ServerHeartbeat;
+        ServerHeartbeat = nullptr;
+    }
+
     if (OnlineAsyncTaskThread)
     {
         // Destroy the online async task thread
@@ -254,6 +276,19 @@ bool FOnlineSubsystemDrift::Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevic
     {
         return true;
     }
+
+    if (FParse::Command(&Cmd, TEXT("MATCHQUEUE")))
+    {
+        return SessionInterface.IsValid() && SessionInterface->HandleMatchQueueExecCommands(InWorld, Cmd, Ar);
+    }
+    if (FParse::Command(&Cmd, TEXT("SEARCHRESULTS")))
+    {
+        return SessionInterface.IsValid() && SessionInterface->HandleSearchResultsExecCommands(InWorld, Cmd, Ar);
+    }
+    if (FParse::Command(&Cmd, TEXT("SESSIONSTATE")))
+    {
+        return SessionInterface.IsValid() && SessionInterface->HandleSessionStateExecCommands(InWorld, Cmd, Ar);
+    }
     return false;
 }
 
@@ -267,3 +302,17 @@ IDriftAPI* FOnlineSubsystemDrift::GetDrift()
 {
     return FDriftWorldHelper{GetInstanceName()}.GetInstance();
 }
+
+
+void FOnlineSubsystemDrift::QueueAsyncTask(FOnlineAsyncTask* AsyncTask)
+{
+    check(OnlineAsyncTaskThreadRunnable);
+    OnlineAsyncTaskThreadRunnable->AddToInQueue(AsyncTask);
+}
+
+
+void FOnlineSubsystemDrift::QueueAsyncOutgoingItem(FOnlineAsyncItem* AsyncItem)
+{
+    check(OnlineAsyncTaskThreadRunnable);
+    OnlineAsyncTaskThreadRunnable->AddToOutQueue(AsyncItem);
+}
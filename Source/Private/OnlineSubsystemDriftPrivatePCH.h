@@ -10,6 +10,9 @@
 
 #define INVALID_INDEX -1
 
+/** Engine ini section holding the Drift subsystem tunables */
+#define DRIFT_CONFIG_SECTION TEXT("OnlineSubsystemDrift")
+
 /** URL Prefix when using Drift socket connection */
 #define NULL_URL_PREFIX TEXT("Drift.")
 
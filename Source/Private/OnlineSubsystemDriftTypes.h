@@ -8,23 +8,51 @@
 class FOnlineSubsystemDrift;
 
 /**
-* Implementation of session information
-*/
-class FOnlineSessionInfoDrift : public FOnlineSessionInfo
+ * Fixed size binary form of a Drift session, what FOnlineSessionInfoDrift::GetBytes() hands out
+ * Fields are in host byte order, every platform Drift runs on is little endian
+ */
+struct FDriftSessionInfoData
 {
-protected:
+    /** Backend match id, 0 for a session that hasn't been registered as a match */
+    uint32 MatchId{ 0 };
+
+    /** IPv4 address of the server, 0 if its url names a host that hasn't been resolved */
+    uint32 Ip{ 0 };
+
+    uint16 Port{ 0 };
+    uint16 Reserved{ 0 };
+
+    /** CRC of the session id, tells apart sessions that have no match id */
+    uint32 SessionKey{ 0 };
+
+    bool operator==(const FDriftSessionInfoData& Other) const
+    {
+        return MatchId == Other.MatchId && Ip == Other.Ip && Port == Other.Port && SessionKey == Other.SessionKey;
+    }
 
-    /** Hidden on purpose */
-    FOnlineSessionInfoDrift(const FOnlineSessionInfoDrift& Src)
+    bool operator!=(const FDriftSessionInfoData& Other) const
     {
+        return !(*this == Other);
     }
 
-    /** Hidden on purpose */
-    FOnlineSessionInfoDrift& operator=(const FOnlineSessionInfoDrift& Src)
+    friend uint32 GetTypeHash(const FDriftSessionInfoData& Data)
     {
-        return *this;
+        return HashCombine(HashCombine(Data.MatchId, Data.SessionKey), HashCombine(Data.Ip, Data.Port));
     }
+};
+
+static_assert(sizeof(FDriftSessionInfoData) == 16, "FDriftSessionInfoData is sent as is, keep it packed");
+
 
+/**
+* Implementation of session information
+*
+* The match id, server address and session key live in FDriftSessionInfoData, which is what GetBytes()
+* hands out and what comparisons and hashing look at. The url is kept for servers that are known by name
+* and for the options that follow the address.
+*/
+class FOnlineSessionInfoDrift : public FOnlineSessionInfo
+{
 PACKAGE_SCOPE:
 
     /** Constructor */
@@ -36,29 +64,67 @@ PACKAGE_SCOPE:
     */
     void Init(const FOnlineSubsystemDrift& Subsystem);
 
+    /** Set the session id to a backend match id */
+    void SetMatchId(int32 MatchId);
+
+    /** Set the server url, the address is taken from it if the host is a dotted IPv4 address */
+    void SetUrl(const FString& InUrl);
+
+    /** Set the address the server's host name resolved to */
+    void SetResolvedAddress(const FInternetAddr& Address);
+
+    /**
+     * Read back a session info sent with GetBytes()
+     * The url is rebuilt from the address, options the server was given aren't part of the binary form
+     *
+     * @return false if the data isn't the size of a Drift session info
+     */
+    bool SetBytes(const uint8* Bytes, int32 Size);
+
+    /** @return the url to connect to, with the address in place of the host name once it's known */
+    FString GetConnectString() const;
+
+    const FString& GetUrl() const { return Url; }
+
+    const FDriftSessionInfoData& GetData() const { return Data; }
+
+private:
+    void SetSessionId(const FString& InSessionId);
+
     /** Unique Id for this session */
     FUniqueNetIdString SessionId;
-    
+
     /** Server URL */
     FString Url;
 
+    FDriftSessionInfoData Data;
+
 public:
 
+    FOnlineSessionInfoDrift(const FOnlineSessionInfoDrift& Src) = default;
+    FOnlineSessionInfoDrift& operator=(const FOnlineSessionInfoDrift& Src) = default;
+
     virtual ~FOnlineSessionInfoDrift() {}
 
     bool operator==(const FOnlineSessionInfoDrift& Other) const
     {
-        return false;
+        // Without an address the url is all that tells two servers apart
+        return Data == Other.Data && (Data.Ip != 0 || Url == Other.Url);
+    }
+
+    friend uint32 GetTypeHash(const FOnlineSessionInfoDrift& SessionInfo)
+    {
+        return GetTypeHash(SessionInfo.Data);
     }
 
     virtual const uint8* GetBytes() const override
     {
-        return NULL;
+        return reinterpret_cast<const uint8*>(&Data);
     }
 
     virtual int32 GetSize() const override
     {
-        return sizeof(uint64) + sizeof(TSharedPtr<class FInternetAddr>);
+        return sizeof(FDriftSessionInfoData);
     }
 
     virtual bool IsValid() const override
@@ -73,7 +139,7 @@ public:
 
     virtual FString ToDebugString() const override
     {
-        return Url.IsEmpty() ? TEXT("INVALID") : Url;
+        return Url.IsEmpty() ? TEXT("INVALID") : FString::Printf(TEXT("%s match: %u key: %08x"), *Url, Data.MatchId, Data.SessionKey);
     }
 
     virtual const FUniqueNetId& GetSessionId() const override
@@ -93,6 +159,7 @@ public:
     }
 
     explicit FUniqueNetIdDrift(const FUniqueNetId& Src)
+    : driftId_{ 0 }
     {
         if (Src.GetSize() == sizeof(driftId_))
         {
@@ -0,0 +1,146 @@
+// Copyright 2016-2017 Directive Games Limited - All Rights Reserved.
+
+#pragma once
+
+#include "OnlineSessionInterface.h"
+#include "OnlineSessionSettings.h"
+
+
+/** Set to true in FOnlineSessionSearch::QuerySettings to get results page by page through OnFindSessionsPage() */
+#define SEARCH_STREAM_RESULTS FName(TEXT("stream_results"))
+
+/** Player skill, in FOnlineSessionSearch::QuerySettings for the searching player and in session settings for a match */
+#define SETTING_DRIFT_SKILL FName(TEXT("skill"))
+
+/** Region to rank first, in FOnlineSessionSearch::QuerySettings, SETTING_REGION is used if it's missing */
+#define SEARCH_RANK_REGION FName(TEXT("rank_region"))
+
+
+/**
+ * Fired for every page of results added to a streaming session search
+ *
+ * @param SearchSettings the search the results were added to
+ * @param FirstNewResult index of the first new entry in SearchResults
+ * @param NumNewResults number of entries added with this page
+ * @param bIsLastPage true when the search is complete, OnFindSessionsComplete follows
+ */
+DECLARE_MULTICAST_DELEGATE_FourParams(FOnFindSessionsPageDelegate, const TSharedRef<FOnlineSessionSearch>&, int32, int32, bool);
+
+/**
+ * Fired when every result handed to IOnlineSessionDrift::PingSearchResults has its PingInMs filled in
+ *
+ * @param SearchSettings the search holding the pinged results
+ */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnSearchResultsPingedDelegate, const TSharedRef<FOnlineSessionSearch>&);
+
+/**
+ * Fired when IOnlineSessionDrift::RankSearchResults has reordered a search
+ *
+ * @param SearchSettings the search holding the results, the best NumRanked of them are now first, best first
+ * @param NumRanked how many results were ranked
+ */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnSearchResultsRankedDelegate, const TSharedRef<FOnlineSessionSearch>&, int32);
+
+
+/**
+ * Where the time of a quick join went, in seconds
+ */
+struct FDriftQuickJoinTimings
+{
+    float Search{ 0.0f };
+    float Ping{ 0.0f };
+    float Rank{ 0.0f };
+    float Join{ 0.0f };
+    float Total{ 0.0f };
+
+    /** Results the search came back with, and how many of them answered the ping */
+    int32 NumResults{ 0 };
+    int32 NumReachable{ 0 };
+
+    FString ToString() const
+    {
+        return FString::Printf(TEXT("search=%.0fms ping=%.0fms rank=%.0fms join=%.0fms total=%.0fms results=%d reachable=%d"),
+            Search * 1000.0f, Ping * 1000.0f, Rank * 1000.0f, Join * 1000.0f, Total * 1000.0f, NumResults, NumReachable);
+    }
+};
+
+/**
+ * Fired when a quick join completes
+ *
+ * @param SessionName the session that was joined
+ * @param Result how the join went
+ * @param ConnectString where to travel to, empty unless successful
+ * @param Timings how long each stage took
+ */
+DECLARE_DELEGATE_FourParams(FOnQuickJoinCompleteDelegate, FName, EOnJoinSessionCompleteResult::Type, const FString&, const FDriftQuickJoinTimings&);
+
+
+/**
+ * Drift's additions to the session interface
+ *
+ * The session interface of the Drift subsystem implements this, so games get at it with
+ * StaticCastSharedPtr<IOnlineSessionDrift>(DriftSubsystem->GetSessionInterface()).
+ */
+class ONLINESUBSYSTEMDRIFT_API IOnlineSessionDrift : public IOnlineSession
+{
+public:
+    using IOnlineSession::CancelFindSessions;
+    using IOnlineSession::PingSearchResults;
+
+    virtual ~IOnlineSessionDrift() {}
+
+    /**
+     * Cancel one search started with FindSessions, leaving any others running
+     * The search is marked failed and no completion fires for it, OnCancelFindSessionsComplete does
+     *
+     * @return false if the search isn't in progress
+     */
+    virtual bool CancelFindSessions(const TSharedRef<FOnlineSessionSearch>& SearchSettings) = 0;
+
+    /** Page by page progress of searches started with SEARCH_STREAM_RESULTS */
+    virtual FOnFindSessionsPageDelegate& OnFindSessionsPage() = 0;
+
+    /**
+     * Measure the latency to a range of search results, all probed concurrently.
+     * Each result gets its PingInMs, MAX_QUERY_PING if the server didn't answer,
+     * and OnSearchResultsPinged() fires once they are all done.
+     * Servers answer on LatencyProbePort, without one nothing is pinged.
+     *
+     * @param SearchSettings the search holding the results
+     * @param FirstResult index of the first result to ping
+     * @param NumResults how many results to ping, INDEX_NONE for all remaining
+     * @return false if no LatencyProbePort is configured, OnSearchResultsPinged() doesn't fire then
+     */
+    virtual bool PingSearchResults(const TSharedRef<FOnlineSessionSearch>& SearchSettings, int32 FirstResult = 0, int32 NumResults = INDEX_NONE) = 0;
+
+    virtual FOnSearchResultsPingedDelegate& OnSearchResultsPinged() = 0;
+
+    /**
+     * Move the best results of a search to the front, best first, scored by ping, how full the match is,
+     * region and skill. Scoring and selection run on the thread pool, the results are reordered on the
+     * game thread, and OnSearchResultsRanked() fires.
+     * If the results change in the meantime, they are left alone and NumRanked is 0.
+     *
+     * @param SearchSettings the search holding the results
+     * @param K how many of the best results to put first, INDEX_NONE for all of them
+     */
+    virtual void RankSearchResults(const TSharedRef<FOnlineSessionSearch>& SearchSettings, int32 K = INDEX_NONE) = 0;
+
+    virtual FOnSearchResultsRankedDelegate& OnSearchResultsRanked() = 0;
+
+    /**
+     * Find a match and join it in one go: search, ping the candidates, rank them, join the best
+     * and resolve where to travel. Full matches are never joined, and servers that don't answer the ping
+     * are only joined if every one that did is full.
+     * The delegate always fires, on a later tick, with a breakdown of where the time went.
+     *
+     * @param PlayerNum the local player joining
+     * @param SessionName the session to join the match as
+     * @param SearchSettings what to search for, it holds the candidates afterwards
+     * @param CompletionDelegate called with the outcome and the connect string
+     * @return false if the quick join couldn't be started
+     */
+    virtual bool QuickJoin(int32 PlayerNum, FName SessionName, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnQuickJoinCompleteDelegate& CompletionDelegate) = 0;
+};
+
+typedef TSharedPtr<IOnlineSessionDrift, ESPMode::ThreadSafe> IOnlineSessionDriftPtr;
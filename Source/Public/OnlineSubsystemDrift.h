@@ -89,7 +89,8 @@ PACKAGE_SCOPE:
         IdentityInterface(nullptr),
         AchievementsInterface(nullptr),
         OnlineAsyncTaskThreadRunnable(nullptr),
-        OnlineAsyncTaskThread(nullptr)
+        OnlineAsyncTaskThread(nullptr),
+        ServerHeartbeat(nullptr)
     {}
 
     FOnlineSubsystemDrift() :
@@ -100,11 +101,27 @@ PACKAGE_SCOPE:
         IdentityInterface(nullptr),
         AchievementsInterface(nullptr),
         OnlineAsyncTaskThreadRunnable(nullptr),
-        OnlineAsyncTaskThread(nullptr)
+        OnlineAsyncTaskThread(nullptr),
+        ServerHeartbeat(nullptr)
     {}
 
     IDriftAPI* GetDrift();
 
+    /**
+     * Add an async task onto the task queue for processing
+     * @param AsyncTask - new heap allocated task to process on the async task thread
+     */
+    void QueueAsyncTask(class FOnlineAsyncTask* AsyncTask);
+
+    /**
+     * Add an async item onto the outgoing queue, to be finalized on the game thread
+     * @param AsyncItem - new heap allocated item, safe to queue from any thread
+     */
+    void QueueAsyncOutgoingItem(class FOnlineAsyncItem* AsyncItem);
+
+    /** Session tasks queued or waiting on Drift, see FOnlineAsyncTaskDriftRequest */
+    FThreadSafeCounter NumPendingSessionTasks;
+
 private:
 
     /** Interface to the session services */
@@ -131,6 +148,9 @@ private:
     /** Online async task thread */
     class FRunnableThread* OnlineAsyncTaskThread;
 
+    /** Status reports to Drift, dedicated server only */
+    class FDriftServerHeartbeat* ServerHeartbeat;
+
     /** Task counter for generating unique thread names */
     static FThreadSafeCounter TaskCounter;
 };